@@ -1,466 +1,2867 @@
 ﻿#include "raylib.h"
+#include "rlgl.h"
 #include <cmath>
 #include <array>
 #include <vector>
 #include <string>
+#include <map>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cctype>
+#include <ctime>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <algorithm>
+#include <bit>
+#include <type_traits>
+#include "audio.h"
+#include "net.h"
+#include "platform.h"
+#include "profiler.h"
+#include "random.h"
+#include "telemetry.h"
 
 constexpr int MAX_OBSTACLES = 30;
 constexpr int PROBE_QUANTITY = 10;
 constexpr int VELOCITY_MULTIPLIER = 50;
 constexpr int LAUNCH_MAX_DISTANCE = 100;
 constexpr float GRAVITY = 1.0f;
+constexpr int TICKS_PER_SECOND = 60;
+constexpr int DEFAULT_SCREEN_WIDTH = 1280;
+constexpr int DEFAULT_SCREEN_HEIGHT = 720;
+constexpr float WORLD_WIDTH = 1280.0f;
+constexpr float WORLD_HEIGHT = 720.0f;
 
 float toRadians(float degrees) {
     return degrees * (PI / 180.0f);
 }
 
-class Obstacle {
-public:
-    Rectangle rect;
-    bool visible;
-    Color fillColor;
-    Color strokeColor;
+// Everything is simulated and drawn in fixed world units. The camera scales
+// the world to the window, letterboxed, so resizes and DPI changes never
+// touch the simulation.
+Camera2D WorldCamera() {
+    float zoom = std::min(GetScreenWidth() / WORLD_WIDTH, GetScreenHeight() / WORLD_HEIGHT);
 
-    Obstacle(Rectangle r, bool v, Color fill, Color stroke)
-        : rect(r), visible(v), fillColor(fill), strokeColor(stroke) {
+    Camera2D camera = {};
+    camera.zoom = zoom;
+    camera.offset = { (GetScreenWidth() - WORLD_WIDTH * zoom) / 2.0f, (GetScreenHeight() - WORLD_HEIGHT * zoom) / 2.0f };
+    return camera;
+}
+
+// Shapes and sprites handed to raylib this frame, for the benchmark. Text is
+// not counted. raylib batches these, so it measures the load on the batcher
+// rather than GPU draw calls.
+uint32_t drawSubmissions = 0;
+
+enum InputFlags : uint8_t {
+    INPUT_PRESS = 1 << 0,
+    INPUT_HOLD = 1 << 1,
+    INPUT_RELEASE = 1 << 2,
+    INPUT_RESET = 1 << 3,
+    INPUT_SELECT = 1 << 4
+};
+
+// Everything the simulation reads from the player in one tick. The mouse is
+// only meaningful while the left button is pressed or held and is zeroed
+// otherwise so idle frames compare equal.
+struct InputFrame {
+    uint8_t flags = 0;
+    uint32_t level = 0;
+    int16_t mouseX = 0;
+    int16_t mouseY = 0;
+
+    bool operator==(const InputFrame& other) const {
+        return flags == other.flags && level == other.level && mouseX == other.mouseX && mouseY == other.mouseY;
     }
 
-    void Draw() const {
-        if (visible) {
-            DrawRectangleRec(rect, fillColor);
-            DrawRectangleLinesEx(rect, 2, strokeColor);
-        }
+    bool operator!=(const InputFrame& other) const {
+        return !(*this == other);
     }
 };
 
-class Ball {
-public:
-    Vector2 pos{};
-    Vector2 vel{};
-    float radius = 40;
-    float friction = 0.99f;
-    float elasticity = 0.9f;
-    float rotationAngle = 0;
-    std::array<float, PROBE_QUANTITY> collisionProbes{ 0, 45, 90, 135, 180, 225, 270, 315 };
-    Texture2D staringTexture{};
-    Texture2D surprisedTexture{};
-    Texture2D launchedTexture{};
-    Texture2D splitTexture{};
-    Color fillColor = BLUE;
-    Color strokeColor = DARKBLUE;
-    bool isSplit = false;
-    bool isActive = true;
-
-    void Draw(bool launched, Ball* selectedBall, float xStart, float yStart) const {
-        if (!isActive) return;
-        if (!launched) {
-            DrawLine(xStart, yStart, pos.x, pos.y, BLACK);
-            float px = pos.x, py = pos.y;
-            float vx = vel.x, vy = vel.y;
+constexpr uint64_t HASH_SEED = 14695981039346656037ull;
 
-            for (int i = 0; i < 50; ++i) {
-                if (i != 0) {
-                    DrawLine(px - vx, py - vy + GRAVITY, px, py, strokeColor);
-                }
-                px += vx;
-                py += vy;
-                vy += GRAVITY;
-            }
-        }
+uint64_t HashBytes(uint64_t hash, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
 
-        Texture2D textureToDraw = staringTexture;
-        if (selectedBall != nullptr)
-            textureToDraw = surprisedTexture;
-        else if (launched) {
-            textureToDraw = isSplit ? splitTexture : launchedTexture;
-        }
+template <typename T>
+uint64_t HashValue(uint64_t hash, const T& value) {
+    return HashBytes(hash, &value, sizeof(T));
+}
 
-        float drawRadius = isSplit ? radius * 0.7f : radius;
+// Little-endian byte packing shared by network packets and saved files.
+class ByteWriter {
+public:
+    std::vector<uint8_t> bytes;
 
-        DrawTexturePro(
-            textureToDraw,
-            { 0, 0, 420, 420 },
-            { pos.x, pos.y, drawRadius * 2, drawRadius * 2 },
-            { (float)drawRadius, (float)drawRadius },
-            rotationAngle,
-            WHITE
-        );
+    void U8(uint8_t value) {
+        bytes.push_back(value);
     }
 
-    float GetProbePosition(bool forX, int probeIndex) {
-        float p = forX ? pos.x : pos.y;
-        float angleRad = toRadians(collisionProbes[probeIndex % PROBE_QUANTITY]);
-        float t = forX ? cosf(angleRad) : sinf(angleRad);
-        float probeRadius = isSplit ? radius * 0.7f : radius;
-        return p + probeRadius * ((probeIndex / PROBE_QUANTITY) > 0 ? 0.5f : 1.0f) * t;
+    void U16(uint16_t value) {
+        U8((uint8_t)value);
+        U8((uint8_t)(value >> 8));
     }
 
-    bool CollidesWith(const Obstacle& obs) {
-        if (!obs.visible || !isActive) return false;
-
-        for (int i = 0; i < PROBE_QUANTITY * 2; ++i) {
-            Vector2 point = { GetProbePosition(true, i), GetProbePosition(false, i) };
-            if (CheckCollisionPointRec(point, obs.rect)) {
-                return true;
-            }
-        }
-
-        return false;
+    void U32(uint32_t value) {
+        U16((uint16_t)value);
+        U16((uint16_t)(value >> 16));
     }
 
-    Ball CreateSplitBall(float angleOffset) const {
-        Ball splitBall = *this;
+    void U64(uint64_t value) {
+        U32((uint32_t)value);
+        U32((uint32_t)(value >> 32));
+    }
 
-        splitBall.isSplit = true;
-        splitBall.radius *= 0.7f;
+    void I16(int16_t value) {
+        U16((uint16_t)value);
+    }
 
-        float currentAngle = atan2f(vel.y, vel.x);
-        float newAngle = currentAngle + toRadians(angleOffset);
-        float speed = sqrtf(vel.x * vel.x + vel.y * vel.y);
+    void F32(float value) {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        U32(bits);
+    }
 
-        splitBall.vel.x = cosf(newAngle) * speed;
-        splitBall.vel.y = sinf(newAngle) * speed;
+    void F64(double value) {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        U64(bits);
+    }
 
-        return splitBall;
+    void VarU32(uint32_t value) {
+        while (value >= 0x80) {
+            U8((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        U8((uint8_t)value);
     }
 };
 
-void DrawCloud(int x, int y, int scale = 1) {
-    Color cloudColor = { 255, 255, 255, 240 };
-
-    DrawEllipse(x, y, 30 * scale, 20 * scale, cloudColor);
-    DrawEllipse(x + 20 * scale, y - 10 * scale, 25 * scale, 18 * scale, cloudColor);
-    DrawEllipse(x + 40 * scale, y, 30 * scale, 20 * scale, cloudColor);
-}
-
-class Button {
+class ByteReader {
 private:
-    Texture2D texture;
-    float scale;
-    bool wasPressed;
+    const uint8_t* data;
+    size_t size;
+    size_t offset = 0;
+    bool failed = false;
 
 public:
-    Vector2 position;
+    ByteReader(const uint8_t* bytes, size_t length) : data(bytes), size(length) {}
 
-    Button(const char* imagePath, Vector2 imagePosition, float scale) : wasPressed(false) {
-        Image image = LoadImage(imagePath);
-        int originalwidth = image.width;
-        int originalheight = image.height;
+    bool Ok() const {
+        return !failed;
+    }
 
-        int newWidth = static_cast<int>(originalwidth * scale);
-        int newheight = static_cast<int>(originalheight * scale);
+    void Fail() {
+        failed = true;
+    }
 
-        ImageResize(&image, newWidth, newheight);
+    size_t Remaining() const {
+        return size - offset;
+    }
 
-        texture = LoadTextureFromImage(image);
-        UnloadImage(image);
+    uint8_t U8() {
+        if (offset >= size) {
+            failed = true;
+            return 0;
+        }
+        return data[offset++];
+    }
 
-        position = imagePosition;
-        this->scale = scale;
+    uint16_t U16() {
+        uint16_t low = U8();
+        return (uint16_t)(low | (U8() << 8));
     }
 
-    ~Button() {
-        UnloadTexture(texture);
+    uint32_t U32() {
+        uint32_t low = U16();
+        return low | ((uint32_t)U16() << 16);
     }
 
-    void Draw() {
-        DrawTextureV(texture, position, WHITE);
+    uint64_t U64() {
+        uint64_t low = U32();
+        return low | ((uint64_t)U32() << 32);
     }
 
-    bool isClicked(Vector2 mousePos) {
-        Rectangle rect = { position.x, position.y, static_cast<float>(texture.width), static_cast<float>(texture.height) };
+    int16_t I16() {
+        return (int16_t)U16();
+    }
 
-        bool isOver = CheckCollisionPointRec(mousePos, rect);
+    float F32() {
+        uint32_t bits = U32();
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
 
-        if (isOver && IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
-            wasPressed = true;
-            return false;
-        }
+    double F64() {
+        uint64_t bits = U64();
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
 
-        if (isOver && wasPressed && IsMouseButtonReleased(MOUSE_BUTTON_LEFT)) {
-            wasPressed = false;
-            return true;
+    // The next count bytes in place, or nullptr if there are fewer left.
+    const uint8_t* Bytes(size_t count) {
+        if (failed || count > size - offset) {
+            failed = true;
+            return nullptr;
         }
+        const uint8_t* bytes = data + offset;
+        offset += count;
+        return bytes;
+    }
 
-        if (IsMouseButtonReleased(MOUSE_BUTTON_LEFT)) {
-            wasPressed = false;
+    uint32_t VarU32() {
+        uint32_t value = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            uint8_t byte = U8();
+            value |= (uint32_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return value;
         }
-
-        return false;
+        failed = true;
+        return 0;
     }
+};
 
-    int getWidth() const {
-        return texture.width;
+// Field reflection for saved and sent structures. A type lists its fields
+// once in a Reflect specialization and Serialize/Deserialize are generated
+// from the list, in declaration order and little-endian on any host. Fields
+// can be stored narrower than in memory (an enum as a byte) or as a VarU32.
+// A field added to a format later names the version it arrived in; reading
+// data written by an older version leaves it as it was.
+//
+// Types made only of fixed-size fields are sized at compile time: writing
+// grows the buffer once and reading checks the length once, then each field
+// is a plain copy. Arrays of numbers whose layout matches the wire are one
+// memcpy on little-endian hosts.
+template <auto Member, typename Wire = void, uint16_t Since = 0>
+struct Field;
+
+template <typename... Fields>
+struct FieldList {};
+
+template <typename T>
+struct Reflect {};
+
+template <typename T>
+concept Reflected = requires { typename Reflect<T>::Fields; };
+
+// Stored as a VarU32 instead of its in-memory width.
+struct VarInt {};
+
+constexpr uint16_t SERIAL_LATEST = UINT16_MAX;
+
+template <typename T>
+constexpr bool COPYABLE_WIRE = std::endian::native == std::endian::little &&
+    ((std::is_arithmetic_v<T> && !std::is_same_v<T, bool>) || std::is_enum_v<T>);
+
+template <typename T>
+struct Codec;
+
+template <typename T>
+    requires (std::is_arithmetic_v<T> || std::is_enum_v<T>)
+struct Codec<T> {
+    static constexpr bool FIXED = true;
+    static constexpr size_t SIZE = sizeof(T);
+
+    static void Store(uint8_t* out, const T& value) {
+        memcpy(out, &value, SIZE);
+        if constexpr (std::endian::native == std::endian::big) std::reverse(out, out + SIZE);
     }
 
-    int getHeight() const {
-        return texture.height;
+    static void Load(const uint8_t* in, T& value) {
+        uint8_t bytes[SIZE];
+        memcpy(bytes, in, SIZE);
+        if constexpr (std::endian::native == std::endian::big) std::reverse(bytes, bytes + SIZE);
+        memcpy(&value, bytes, SIZE);
     }
 };
 
-enum class LevelState {
-    PLAYING,
-    COMPLETED,
-    FAILED
-};
+template <>
+struct Codec<bool> {
+    static constexpr bool FIXED = true;
+    static constexpr size_t SIZE = 1;
 
-class Level {
-public:
-    std::vector<Obstacle> obstacles;
-    std::string name;
-    int targetScore;
-    bool initialized = false;
-    LevelState state = LevelState::PLAYING;
+    static void Store(uint8_t* out, const bool& value) {
+        *out = value ? 1 : 0;
+    }
 
-    Level(const std::string& levelName, int requiredScore) : name(levelName), targetScore(requiredScore) {}
+    static void Load(const uint8_t* in, bool& value) {
+        value = *in != 0;
+    }
+};
 
-    virtual void Initialize(float groundY) = 0;
+template <typename C>
+constexpr size_t FixedSize() {
+    if constexpr (C::FIXED) return C::SIZE;
+    else return 0;
+}
 
-    void Reset() {
-        for (auto& obs : obstacles) {
-            obs.visible = true;
-        }
-        state = LevelState::PLAYING;
+template <typename C, typename T>
+void WriteWith(ByteWriter& writer, const T& value) {
+    if constexpr (C::FIXED) {
+        size_t at = writer.bytes.size();
+        writer.bytes.resize(at + C::SIZE);
+        C::Store(writer.bytes.data() + at, value);
     }
-
-    int GetCurrentScore() {
-        int score = 0;
-        for (const auto& obs : obstacles) {
-            if (!obs.visible) {
-                score += 10;
-            }
-        }
-        return score;
+    else {
+        C::Write(writer, value);
     }
+}
 
-    void Update() {
-        if (GetCurrentScore() >= targetScore) {
-            state = LevelState::COMPLETED;
-        }
+template <typename C, typename T>
+void ReadWith(ByteReader& reader, T& value, uint16_t version) {
+    if constexpr (C::FIXED) {
+        if (const uint8_t* in = reader.Bytes(C::SIZE)) C::Load(in, value);
     }
+    else {
+        C::Read(reader, value, version);
+    }
+}
 
-    virtual ~Level() {}
-};
+template <typename T>
+void StoreItems(uint8_t* out, const T* items, size_t count) {
+    if constexpr (COPYABLE_WIRE<T>) {
+        if (count > 0) memcpy(out, items, count * sizeof(T));
+    }
+    else {
+        for (size_t i = 0; i < count; ++i) Codec<T>::Store(out + i * Codec<T>::SIZE, items[i]);
+    }
+}
 
+template <typename T>
+void LoadItems(const uint8_t* in, T* items, size_t count) {
+    if constexpr (COPYABLE_WIRE<T>) {
+        if (count > 0) memcpy(items, in, count * sizeof(T));
+    }
+    else {
+        for (size_t i = 0; i < count; ++i) Codec<T>::Load(in + i * Codec<T>::SIZE, items[i]);
+    }
+}
 
-class Level1 : public Level {
-public:
-    Level1() : Level("Starter Tower", 100) {}
+template <typename T>
+void Serialize(ByteWriter& writer, const T& value) {
+    WriteWith<Codec<T>>(writer, value);
+}
 
-    void Initialize(float groundY) override {
-        obstacles.clear();
+template <typename T>
+bool Deserialize(ByteReader& reader, T& value, uint16_t version = SERIAL_LATEST) {
+    ReadWith<Codec<T>>(reader, value, version);
+    return reader.Ok();
+}
 
-        float centerX = 800.0f;
-        float blockWidth = 30.0f;
-        float blockHeight = 40.0f;
-        float blockSpacing = 35.0f;
+template <typename T>
+void SerializeItems(ByteWriter& writer, const T* items, size_t count) {
+    if constexpr (Codec<T>::FIXED) {
+        size_t at = writer.bytes.size();
+        writer.bytes.resize(at + count * Codec<T>::SIZE);
+        StoreItems(writer.bytes.data() + at, items, count);
+    }
+    else {
+        for (size_t i = 0; i < count; ++i) WriteWith<Codec<T>>(writer, items[i]);
+    }
+}
 
-        int baseLayerSize = 9;
-        float baseStartX = centerX - ((baseLayerSize - 1) * blockSpacing / 2);
-        for (int i = 0; i < baseLayerSize; ++i) {
-            obstacles.push_back({ { baseStartX + i * blockSpacing, groundY - blockHeight, blockWidth, blockHeight }, true, GREEN, DARKGREEN });
-        }
+template <typename T>
+bool DeserializeItems(ByteReader& reader, T* items, size_t count, uint16_t version = SERIAL_LATEST) {
+    if constexpr (Codec<T>::FIXED) {
+        if (const uint8_t* in = reader.Bytes(count * Codec<T>::SIZE)) LoadItems(in, items, count);
+    }
+    else {
+        for (size_t i = 0; i < count && reader.Ok(); ++i) ReadWith<Codec<T>>(reader, items[i], version);
+    }
+    return reader.Ok();
+}
 
-        int secondLayerSize = 7;
-        float secondStartX = centerX - ((secondLayerSize - 1) * blockSpacing / 2);
-        for (int i = 0; i < secondLayerSize; ++i) {
-            obstacles.push_back({ { secondStartX + i * blockSpacing, groundY - blockHeight * 2, blockWidth, blockHeight }, true, YELLOW, GOLD });
-        }
+template <typename T, size_t N>
+struct Codec<std::array<T, N>> {
+    static constexpr bool FIXED = Codec<T>::FIXED;
+    static constexpr size_t SIZE = N * FixedSize<Codec<T>>();
 
-        int thirdLayerSize = 5;
-        float thirdStartX = centerX - ((thirdLayerSize - 1) * blockSpacing / 2);
-        for (int i = 0; i < thirdLayerSize; ++i) {
-            obstacles.push_back({ { thirdStartX + i * blockSpacing, groundY - blockHeight * 3, blockWidth, blockHeight }, true, ORANGE, BROWN });
-        }
+    static void Store(uint8_t* out, const std::array<T, N>& items) {
+        StoreItems(out, items.data(), N);
+    }
 
-        int fourthLayerSize = 3;
-        float fourthStartX = centerX - ((fourthLayerSize - 1) * blockSpacing / 2);
-        for (int i = 0; i < fourthLayerSize; ++i) {
-            obstacles.push_back({ { fourthStartX + i * blockSpacing, groundY - blockHeight * 4, blockWidth, blockHeight }, true, BLUE, DARKBLUE });
-        }
+    static void Load(const uint8_t* in, std::array<T, N>& items) {
+        LoadItems(in, items.data(), N);
+    }
 
-        obstacles.push_back({ { centerX - blockWidth / 2, groundY - blockHeight * 5, blockWidth, blockHeight }, true, RED, MAROON });
+    static void Write(ByteWriter& writer, const std::array<T, N>& items) {
+        SerializeItems(writer, items.data(), N);
+    }
 
-        initialized = true;
+    static void Read(ByteReader& reader, std::array<T, N>& items, uint16_t version) {
+        DeserializeItems(reader, items.data(), N, version);
     }
 };
 
-class Level2 : public Level {
-public:
-    Level2() : Level("Fortified Castle", 150) {}
-
-    void Initialize(float groundY) override {
-        obstacles.clear();
+// VarU32 count, then the items.
+template <typename T>
+struct Codec<std::vector<T>> {
+    static constexpr bool FIXED = false;
 
-        const float blockSize = 40.0f;
-        const float smallBlockSize = 20.0f;
-        const float castleBaseX = 700.0f;
-        const float baseWidth = 8 * blockSize;
+    static void Write(ByteWriter& writer, const std::vector<T>& items) {
+        writer.VarU32((uint32_t)items.size());
+        SerializeItems(writer, items.data(), items.size());
+    }
 
-        for (int i = 0; i < 8; i++) {
-            obstacles.push_back({ { castleBaseX + i * blockSize, groundY - blockSize, blockSize, blockSize }, true, GRAY, DARKGRAY });
-            obstacles.push_back({ { castleBaseX + i * blockSize, groundY - 2 * blockSize, blockSize, blockSize }, true, GRAY, DARKGRAY });
+    static void Read(ByteReader& reader, std::vector<T>& items, uint16_t version) {
+        uint32_t count = reader.VarU32();
+        if (count > reader.Remaining() / std::max<size_t>(FixedSize<Codec<T>>(), 1)) {
+            reader.Fail();
+            return;
         }
+        items.resize(count);
+        DeserializeItems(reader, items.data(), count, version);
+    }
+};
 
-        obstacles.push_back({ { castleBaseX, groundY - 3 * blockSize, blockSize, blockSize }, true, SKYBLUE, DARKBLUE });
-        obstacles.push_back({ { castleBaseX, groundY - 4 * blockSize, blockSize, blockSize }, true, SKYBLUE, DARKBLUE });
-        obstacles.push_back({ { castleBaseX, groundY - 5 * blockSize, blockSize, blockSize }, true, SKYBLUE, DARKBLUE });
-
-        obstacles.push_back({ { castleBaseX + 7 * blockSize, groundY - 3 * blockSize, blockSize, blockSize }, true, SKYBLUE, DARKBLUE });
-        obstacles.push_back({ { castleBaseX + 7 * blockSize, groundY - 4 * blockSize, blockSize, blockSize }, true, SKYBLUE, DARKBLUE });
-        obstacles.push_back({ { castleBaseX + 7 * blockSize, groundY - 5 * blockSize, blockSize, blockSize }, true, SKYBLUE, DARKBLUE });
+// VarU32 count, then key and value pairs in key order.
+template <typename K, typename V>
+struct Codec<std::map<K, V>> {
+    static constexpr bool FIXED = false;
 
-        for (int i = 1; i < 7; i++) {
-            if (i == 3 || i == 4) continue;
-            obstacles.push_back({ { castleBaseX + i * blockSize, groundY - 3 * blockSize, blockSize, blockSize }, true, SKYBLUE, DARKBLUE });
-            obstacles.push_back({ { castleBaseX + i * blockSize, groundY - 4 * blockSize, blockSize, blockSize }, true, SKYBLUE, DARKBLUE });
+    static void Write(ByteWriter& writer, const std::map<K, V>& entries) {
+        writer.VarU32((uint32_t)entries.size());
+        for (const auto& entry : entries) {
+            WriteWith<Codec<K>>(writer, entry.first);
+            WriteWith<Codec<V>>(writer, entry.second);
         }
+    }
 
-        for (int i = 0; i < 8; i++) {
-            obstacles.push_back({ { castleBaseX + i * blockSize, groundY - 5 * blockSize, blockSize, blockSize }, true, SKYBLUE, DARKBLUE });
+    static void Read(ByteReader& reader, std::map<K, V>& entries, uint16_t version) {
+        uint32_t count = reader.VarU32();
+        if (count > reader.Remaining()) {
+            reader.Fail();
+            return;
         }
-
-        obstacles.push_back({ { castleBaseX, groundY - 6 * blockSize, blockSize, blockSize }, true, SKYBLUE, DARKBLUE });
-        obstacles.push_back({ { castleBaseX, groundY - 7 * blockSize, blockSize, blockSize }, true, SKYBLUE, DARKBLUE });
-
-        obstacles.push_back({ { castleBaseX + 7 * blockSize, groundY - 6 * blockSize, blockSize, blockSize }, true, SKYBLUE, DARKBLUE });
-        obstacles.push_back({ { castleBaseX + 7 * blockSize, groundY - 7 * blockSize, blockSize, blockSize }, true, SKYBLUE, DARKBLUE });
-
-        obstacles.push_back({ { castleBaseX + 2 * blockSize, groundY - 6 * blockSize, blockSize, blockSize }, true, SKYBLUE, DARKBLUE });
-        obstacles.push_back({ { castleBaseX + 5 * blockSize, groundY - 6 * blockSize, blockSize, blockSize }, true, SKYBLUE, DARKBLUE });
-
-        for (int i = 0; i < 8; i++) {
-            if (i != 1 && i != 3 && i != 4 && i != 6) {
-                obstacles.push_back({ { castleBaseX + i * blockSize, groundY - 7 * blockSize, blockSize, blockSize }, true, SKYBLUE, DARKBLUE });
-            }
+        entries.clear();
+        for (uint32_t i = 0; i < count && reader.Ok(); ++i) {
+            K key{};
+            V value{};
+            ReadWith<Codec<K>>(reader, key, version);
+            ReadWith<Codec<V>>(reader, value, version);
+            entries[key] = value;
         }
+    }
+};
 
-        obstacles.push_back({ { castleBaseX + 3 * blockSize, groundY - 6 * blockSize, 2 * blockSize, blockSize }, true, BLUE, DARKBLUE });
-        obstacles.push_back({ { castleBaseX + 3 * blockSize, groundY - 7 * blockSize, 2 * blockSize, blockSize }, true, BLUE, DARKBLUE });
-        obstacles.push_back({ { castleBaseX + 3 * blockSize, groundY - 8 * blockSize, 2 * blockSize, blockSize }, true, BLUE, DARKBLUE });
-        obstacles.push_back({ { castleBaseX + 3 * blockSize, groundY - 9 * blockSize, 2 * blockSize, blockSize }, true, PURPLE, DARKPURPLE });
-
-        obstacles.push_back({ { castleBaseX - blockSize, groundY - blockSize, blockSize, blockSize }, true, DARKGRAY, BLACK });
-        obstacles.push_back({ { castleBaseX - blockSize, groundY - 2 * blockSize, blockSize, blockSize }, true, DARKGRAY, BLACK });
-
-        obstacles.push_back({ { castleBaseX + 8 * blockSize, groundY - blockSize, blockSize, blockSize }, true, DARKGRAY, BLACK });
-        obstacles.push_back({ { castleBaseX + 8 * blockSize, groundY - 2 * blockSize, blockSize, blockSize }, true, DARKGRAY, BLACK });
+// How one field is stored: as its own type, converted to Wire, or as a VarU32.
+template <typename T, typename Wire>
+struct FieldCodec {
+    static constexpr bool FIXED = true;
+    static constexpr size_t SIZE = Codec<Wire>::SIZE;
 
-        obstacles.push_back({ { castleBaseX + 3.5f * blockSize - smallBlockSize, groundY - 7.5f * blockSize, smallBlockSize * 2, smallBlockSize * 2 }, true, SKYBLUE, BLUE });
+    static void Store(uint8_t* out, const T& value) {
+        Codec<Wire>::Store(out, static_cast<Wire>(value));
+    }
 
-        initialized = true;
+    static void Load(const uint8_t* in, T& value) {
+        Wire wire;
+        Codec<Wire>::Load(in, wire);
+        value = static_cast<T>(wire);
     }
 };
 
-class Level3 : public Level {
-public:
-    Level3() : Level("Stronghold", 250) {}
+template <typename T>
+struct FieldCodec<T, void> : Codec<T> {};
 
-    void Initialize(float groundY) override {
-        obstacles.clear();
+template <typename T>
+struct FieldCodec<T, VarInt> {
+    static constexpr bool FIXED = false;
 
-        float centerX = 800.0f;
-        float baseY = groundY - 40.0f;
-        float blockSize = 40.0f;
+    static void Write(ByteWriter& writer, const T& value) {
+        writer.VarU32((uint32_t)value);
+    }
 
-        CreateSquare(centerX, baseY, 11, blockSize, BLACK, BLACK);
+    static void Read(ByteReader& reader, T& value, uint16_t) {
+        value = static_cast<T>(reader.VarU32());
+    }
+};
 
-        CreateSquare(centerX, baseY - blockSize, 9, blockSize, DARKGRAY, BLACK);
+template <typename C, typename T>
+T MemberTypeOf(T C::*);
 
-        CreateSquare(centerX, baseY - 2 * blockSize, 7, blockSize, GRAY, DARKGRAY);
+template <auto Member, typename Wire, uint16_t Since>
+struct Field {
+    using Coding = FieldCodec<decltype(MemberTypeOf(Member)), Wire>;
+    static constexpr auto MEMBER = Member;
+    static constexpr uint16_t SINCE = Since;
+};
 
-        CreateSquare(centerX, baseY - 3 * blockSize, 5, blockSize, DARKBLUE, BLACK);
+template <typename T, typename List>
+struct StructCodec;
 
-        CreateSquare(centerX, baseY - 4 * blockSize, 3, blockSize, BLUE, DARKBLUE);
+template <typename T, typename... Fields>
+struct StructCodec<T, FieldList<Fields...>> {
+    static constexpr bool FIXED = ((Fields::Coding::FIXED && Fields::SINCE == 0) && ...);
+    static constexpr size_t SIZE = (FixedSize<typename Fields::Coding>() + ...);
 
-        obstacles.push_back({ { centerX - blockSize / 2, baseY - 5 * blockSize - blockSize / 2, blockSize, blockSize }, true, GOLD, ORANGE });
+    static void Store(uint8_t* out, const T& value) {
+        ((Fields::Coding::Store(out, value.*Fields::MEMBER), out += Fields::Coding::SIZE), ...);
+    }
 
-        initialized = true;
+    static void Load(const uint8_t* in, T& value) {
+        ((Fields::Coding::Load(in, value.*Fields::MEMBER), in += Fields::Coding::SIZE), ...);
     }
 
-private:
-    void CreateSquare(float centerX, float baseY, int size, float blockSize, Color mainColor, Color outlineColor) {
-        float offset = (size * blockSize) / 2.0f;
+    static void Write(ByteWriter& writer, const T& value) {
+        (WriteWith<typename Fields::Coding>(writer, value.*Fields::MEMBER), ...);
+    }
 
-        for (int i = 0; i < size; i++) {
+    static void Read(ByteReader& reader, T& value, uint16_t version) {
+        ((Fields::SINCE <= version ? ReadWith<typename Fields::Coding>(reader, value.*Fields::MEMBER, version) : void()), ...);
+    }
+};
 
-            obstacles.push_back({ { centerX - offset + (i * blockSize), baseY, blockSize, blockSize },
-                                 true, mainColor, outlineColor });
+template <Reflected T>
+struct Codec<T> : StructCodec<T, typename Reflect<T>::Fields> {};
 
+template <>
+struct Reflect<Vector2> {
+    using Fields = FieldList<Field<&Vector2::x>, Field<&Vector2::y>>;
+};
 
-            obstacles.push_back({ { centerX - offset + (i * blockSize), baseY - (size - 1) * blockSize,
-                                 blockSize, blockSize }, true, mainColor, outlineColor });
+template <>
+struct Reflect<Rectangle> {
+    using Fields = FieldList<Field<&Rectangle::x>, Field<&Rectangle::y>, Field<&Rectangle::width>, Field<&Rectangle::height>>;
+};
 
+template <>
+struct Reflect<Color> {
+    using Fields = FieldList<Field<&Color::r>, Field<&Color::g>, Field<&Color::b>, Field<&Color::a>>;
+};
 
-            if (i > 0 && i < size - 1) {
-                obstacles.push_back({ { centerX - offset, baseY - (i * blockSize),
-                                     blockSize, blockSize }, true, mainColor, outlineColor });
-            }
+enum CollisionLayer : uint8_t {
+    LAYER_BLOCK = 1 << 0,
+    LAYER_BIRD = 1 << 1,
+    LAYER_SHARD = 1 << 2,
+    LAYER_GROUND = 1 << 3
+};
 
+// Which layer a collider is on and which layers it wants to touch. A pair is
+// only tested when each side's mask accepts the other's layer, so kinds that
+// never interact (birds and birds, debris and debris) cost nothing.
+struct CollisionFilter {
+    uint8_t layer = 0;
+    uint8_t mask = 0;
 
-            if (i > 0 && i < size - 1) {
-                obstacles.push_back({ { centerX + offset - blockSize, baseY - (i * blockSize),
-                                     blockSize, blockSize }, true, mainColor, outlineColor });
-            }
-        }
+    constexpr bool Accepts(const CollisionFilter& other) const {
+        return (mask & other.layer) != 0 && (other.mask & layer) != 0;
+    }
+
+    constexpr bool Touches(CollisionLayer other) const {
+        return (mask & other) != 0;
     }
 };
 
+template <>
+struct Reflect<CollisionFilter> {
+    using Fields = FieldList<Field<&CollisionFilter::layer>, Field<&CollisionFilter::mask>>;
+};
 
+constexpr CollisionFilter BLOCK_FILTER = { LAYER_BLOCK, LAYER_BIRD };
+constexpr CollisionFilter BIRD_FILTER = { LAYER_BIRD, LAYER_BLOCK | LAYER_GROUND };
+constexpr CollisionFilter SHARD_FILTER = { LAYER_SHARD, LAYER_GROUND };
 
-class Level4 : public Level {
+class Obstacle {
 public:
-    Level4() : Level("Ultimate Challenge", 250) {}
-
-    void Initialize(float groundY) override {
-        obstacles.clear();
-
+    Rectangle rect;
+    bool visible;
+    Color fillColor;
+    Color strokeColor;
+    CollisionFilter filter = BLOCK_FILTER;
 
-        const float blockSize = 40.0f;
-        const float leftTowerX = 700.0f;
-        const float rightTowerX = 900.0f;
-        const float towerHeight = 10;
-        const float towerWidth = 3;
+    constexpr Obstacle() : rect{}, visible(false), fillColor{}, strokeColor{} {}
 
+    constexpr Obstacle(Rectangle r, bool v, Color fill, Color stroke)
+        : rect(r), visible(v), fillColor(fill), strokeColor(stroke) {
+    }
 
-        for (int height = 0; height < towerHeight; height++) {
-            for (int width = 0; width < towerWidth; width++) {
-                obstacles.push_back({ { leftTowerX + width * blockSize, groundY - (height + 1) * blockSize, blockSize, blockSize }, true, BLUE, DARKBLUE });
-            }
+    void Draw() const {
+        if (visible) {
+            DrawRectangleRec(rect, fillColor);
+            DrawRectangleLinesEx(rect, 2, strokeColor);
+            drawSubmissions += 2;
         }
+    }
+};
 
-        for (int height = 0; height < towerHeight; height++) {
-            for (int width = 0; width < towerWidth; width++) {
-                obstacles.push_back({ { rightTowerX + width * blockSize, groundY - (height + 1) * blockSize, blockSize, blockSize }, true, BLUE, DARKBLUE });
-            }
-        }
+// Level files store the shape and colours; every loaded block starts visible.
+template <>
+struct Reflect<Obstacle> {
+    using Fields = FieldList<Field<&Obstacle::rect>, Field<&Obstacle::fillColor>, Field<&Obstacle::strokeColor>>;
+};
 
+enum class BirdType : uint8_t {
+    NORMAL,
+    SPLIT,
+    HEAVY,
+    EXPLOSIVE,
+    BOOMERANG
+};
 
-        int platformLength = (rightTowerX - (leftTowerX + towerWidth * blockSize)) / blockSize;
+constexpr int BIRD_TYPE_COUNT = 5;
+constexpr int BIRDS_PER_LEVEL = 3;
+
+// Bird archetypes as compile-time policies. The flight step is instantiated
+// once per policy, so each bird's behaviour is folded into its own loop
+// instead of being branched on per ball.
+struct NormalBird {
+    static constexpr BirdType TYPE = BirdType::NORMAL;
+    static constexpr const char* NAME = "Normal";
+    static constexpr float RADIUS = 40.0f;
+    static constexpr Color TINT = WHITE;
+    // Share of horizontal speed kept after smashing a block; 0 uses the
+    // ball's elasticity like a bounce.
+    static constexpr float IMPACT_SPEED_KEPT = 0.0f;
+    // Blocks whose centre is this close to the first impact are destroyed too.
+    static constexpr float BLAST_RADIUS = 0.0f;
+    // Horizontal pull back towards the slingshot while falling from height,
+    // up to RETURN_SPEED.
+    static constexpr float RETURN_PULL = 0.0f;
+    static constexpr float RETURN_SPEED = 0.0f;
+};
 
+struct SplitBird : NormalBird {
+    static constexpr BirdType TYPE = BirdType::SPLIT;
+    static constexpr const char* NAME = "Split";
+    static constexpr float RADIUS = NormalBird::RADIUS * 0.7f;
+};
 
-        for (int i = 0; i < platformLength; i++) {
-            obstacles.push_back({ { leftTowerX + towerWidth * blockSize + i * blockSize, groundY - towerHeight * blockSize, blockSize, blockSize }, true, BLUE, DARKBLUE });
-        }
+struct HeavyBird : NormalBird {
+    static constexpr BirdType TYPE = BirdType::HEAVY;
+    static constexpr const char* NAME = "Heavy";
+    static constexpr float RADIUS = 48.0f;
+    static constexpr Color TINT = { 170, 170, 190, 255 };
+    static constexpr float IMPACT_SPEED_KEPT = 0.98f;
+};
 
+struct ExplosiveBird : NormalBird {
+    static constexpr BirdType TYPE = BirdType::EXPLOSIVE;
+    static constexpr const char* NAME = "Explosive";
+    static constexpr Color TINT = { 255, 140, 120, 255 };
+    static constexpr float BLAST_RADIUS = 90.0f;
+};
 
-        float centerX = leftTowerX + towerWidth * blockSize + (platformLength * blockSize) / 2.0f - blockSize / 2.0f;
+struct BoomerangBird : NormalBird {
+    static constexpr BirdType TYPE = BirdType::BOOMERANG;
+    static constexpr const char* NAME = "Boomerang";
+    static constexpr float RADIUS = 36.0f;
+    static constexpr Color TINT = { 255, 230, 120, 255 };
+    static constexpr float RETURN_PULL = 0.6f;
+    static constexpr float RETURN_SPEED = 12.0f;
+};
 
+struct BirdTraits {
+    const char* name;
+    float radius;
+    Color tint;
+};
 
-        obstacles.push_back({ { centerX, groundY - (towerHeight + 1) * blockSize, blockSize, blockSize }, true, GOLD, ORANGE });
+template <class Bird>
+constexpr BirdTraits TraitsOf() {
+    return { Bird::NAME, Bird::RADIUS, Bird::TINT };
+}
 
-        initialized = true;
-    }
+constexpr BirdTraits BIRD_TRAITS[BIRD_TYPE_COUNT] = {
+    TraitsOf<NormalBird>(),
+    TraitsOf<SplitBird>(),
+    TraitsOf<HeavyBird>(),
+    TraitsOf<ExplosiveBird>(),
+    TraitsOf<BoomerangBird>()
 };
-class GameWorld {
+
+static_assert((int)BoomerangBird::TYPE == BIRD_TYPE_COUNT - 1, "BIRD_TRAITS is indexed by BirdType");
+
+class Ball {
 public:
-    Ball ball;
-    std::vector<Ball> splitBalls;
-    Level* currentLevel = nullptr;
-    Level1 level1;
-    Level2 level2;
-    Level3 level3;
-    Level4 level4;
+    Vector2 pos{};
+    Vector2 vel{};
+    float radius = NormalBird::RADIUS;
+    float friction = 0.99f;
+    float elasticity = 0.9f;
+    float rotationAngle = 0;
+    std::array<float, PROBE_QUANTITY> collisionProbes{ 0, 45, 90, 135, 180, 225, 270, 315 };
+    Color fillColor = BLUE;
+    Color strokeColor = DARKBLUE;
+    BirdType type = BirdType::NORMAL;
+    bool isActive = true;
+    CollisionFilter filter = BIRD_FILTER;
+
+    void Draw(Texture2D face, bool launched, float xStart, float yStart) const {
+        if (!isActive) return;
+        if (!launched) {
+            DrawLine(xStart, yStart, pos.x, pos.y, BLACK);
+            float px = pos.x, py = pos.y;
+            float vx = vel.x, vy = vel.y;
+
+            for (int i = 0; i < 50; ++i) {
+                if (i != 0) {
+                    DrawLine(px - vx, py - vy + GRAVITY, px, py, strokeColor);
+                }
+                px += vx;
+                py += vy;
+                vy += GRAVITY;
+            }
+            drawSubmissions += 50;
+        }
+
+        drawSubmissions++;
+        DrawTexturePro(
+            face,
+            { 0, 0, 420, 420 },
+            { pos.x, pos.y, radius * 2, radius * 2 },
+            { radius, radius },
+            rotationAngle,
+            BIRD_TRAITS[(int)type].tint
+        );
+    }
+
+    float GetProbePosition(bool forX, int probeIndex) {
+        float p = forX ? pos.x : pos.y;
+        float angleRad = toRadians(collisionProbes[probeIndex % PROBE_QUANTITY]);
+        float t = forX ? cosf(angleRad) : sinf(angleRad);
+        return p + radius * ((probeIndex / PROBE_QUANTITY) > 0 ? 0.5f : 1.0f) * t;
+    }
+
+    bool CollidesWith(const Obstacle& obs) {
+        if (!obs.visible || !isActive) return false;
+
+        for (int i = 0; i < PROBE_QUANTITY * 2; ++i) {
+            Vector2 point = { GetProbePosition(true, i), GetProbePosition(false, i) };
+            if (CheckCollisionPointRec(point, obs.rect)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    Ball CreateSplitBall(float angleOffset) const {
+        Ball splitBall = *this;
+
+        splitBall.type = BirdType::SPLIT;
+        splitBall.radius = SplitBird::RADIUS;
+
+        float currentAngle = atan2f(vel.y, vel.x);
+        float newAngle = currentAngle + toRadians(angleOffset);
+        float speed = sqrtf(vel.x * vel.x + vel.y * vel.y);
+
+        splitBall.vel.x = cosf(newAngle) * speed;
+        splitBall.vel.y = sinf(newAngle) * speed;
+
+        return splitBall;
+    }
+};
+
+template <>
+struct Reflect<Ball> {
+    using Fields = FieldList<Field<&Ball::pos>, Field<&Ball::vel>, Field<&Ball::radius>, Field<&Ball::friction>,
+        Field<&Ball::elasticity>, Field<&Ball::rotationAngle>, Field<&Ball::collisionProbes>,
+        Field<&Ball::fillColor>, Field<&Ball::strokeColor>, Field<&Ball::type>, Field<&Ball::isActive>,
+        Field<&Ball::filter>>;
+};
+
+void DrawCloud(int x, int y, int scale = 1) {
+    Color cloudColor = { 255, 255, 255, 240 };
+
+    DrawEllipse(x, y, 30 * scale, 20 * scale, cloudColor);
+    DrawEllipse(x + 20 * scale, y - 10 * scale, 25 * scale, 18 * scale, cloudColor);
+    DrawEllipse(x + 40 * scale, y, 30 * scale, 20 * scale, cloudColor);
+}
+
+struct TextureHandle {
+    int index = -1;
+};
+
+// Every texture loaded from an asset file goes through here, so GPU memory
+// is accounted per asset. With a budget set, textures not drawn in the
+// current frame are evicted least recently used first once the total goes
+// over it, and reloaded from their file the next time they are used.
+class TextureCache {
+private:
+    struct Entry {
+        std::string path;
+        float scale = 1.0f;
+        Texture2D texture{};
+        size_t bytes = 0;
+        uint64_t lastUsed = 0;
+        int loads = 0;
+        bool missing = false;
+    };
+
+    std::vector<Entry> entries;
+    size_t residentBytes = 0;
+    size_t budgetBytes = 0;
+    uint64_t frame = 1;
+    int evictions = 0;
+
+    static size_t TextureBytes(const Texture2D& texture) {
+        size_t bytes = 0;
+        int width = texture.width, height = texture.height;
+        for (int level = 0; level < std::max(1, texture.mipmaps); ++level) {
+            bytes += (size_t)GetPixelDataSize(width, height, texture.format);
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+        }
+        return bytes;
+    }
+
+    void Load(Entry& entry) {
+        if (entry.scale == 1.0f) {
+            entry.texture = LoadTexture(entry.path.c_str());
+        }
+        else {
+            Image image = LoadImage(entry.path.c_str());
+            if (image.data != nullptr) {
+                ImageResize(&image, (int)(image.width * entry.scale), (int)(image.height * entry.scale));
+                entry.texture = LoadTextureFromImage(image);
+            }
+            UnloadImage(image);
+        }
+
+        entry.loads++;
+        entry.missing = entry.texture.id == 0;
+        entry.bytes = entry.missing ? 0 : TextureBytes(entry.texture);
+        residentBytes += entry.bytes;
+    }
+
+    void Unload(Entry& entry) {
+        if (entry.texture.id == 0) return;
+        UnloadTexture(entry.texture);
+        entry.texture = {};
+        residentBytes -= entry.bytes;
+    }
+
+public:
+    // Returns the handle for an asset, loaded at the given scale. Nothing is
+    // loaded until the first Get.
+    TextureHandle Register(const char* path, float scale = 1.0f) {
+        for (size_t i = 0; i < entries.size(); ++i) {
+            if (entries[i].path == path && entries[i].scale == scale) return { (int)i };
+        }
+        Entry entry;
+        entry.path = path;
+        entry.scale = scale;
+        entries.push_back(entry);
+        return { (int)entries.size() - 1 };
+    }
+
+    // The texture for a handle, loading it if it is not resident. Assets
+    // that failed to load come back with id 0 and are not retried.
+    Texture2D Get(TextureHandle handle) {
+        if (handle.index < 0) return {};
+
+        Entry& entry = entries[handle.index];
+        if (entry.texture.id == 0 && !entry.missing) Load(entry);
+        entry.lastUsed = frame;
+        return entry.texture;
+    }
+
+    void SetBudget(size_t bytes) {
+        budgetBytes = bytes;
+    }
+
+    // Call once per frame after drawing.
+    void EndFrame() {
+        while (budgetBytes > 0 && residentBytes > budgetBytes) {
+            Entry* victim = nullptr;
+            for (auto& entry : entries) {
+                if (entry.texture.id != 0 && entry.lastUsed < frame && (victim == nullptr || entry.lastUsed < victim->lastUsed)) {
+                    victim = &entry;
+                }
+            }
+            if (victim == nullptr) break;
+
+            Unload(*victim);
+            evictions++;
+        }
+        frame++;
+    }
+
+    void UnloadAll() {
+        for (auto& entry : entries) Unload(entry);
+    }
+
+    void DrawOverlay(int x, int y) const {
+        int lines = 2;
+        for (const auto& entry : entries) lines += entry.texture.id != 0 || entry.loads > 0 ? 1 : 0;
+        DrawRectangle(x - 8, y - 8, 460, lines * 18 + 12, { 0, 0, 0, 190 });
+
+        bool overBudget = budgetBytes > 0 && residentBytes > budgetBytes;
+        DrawText(TextFormat("Textures: %.2f MB / %s, %d evictions", residentBytes / 1048576.0,
+            budgetBytes > 0 ? TextFormat("%.2f MB", budgetBytes / 1048576.0) : "no budget", evictions),
+            x, y, 16, overBudget ? RED : WHITE);
+        y += 18;
+        DrawText("(F3 to hide)", x, y, 16, GRAY);
+        y += 18;
+
+        for (const auto& entry : entries) {
+            if (entry.texture.id == 0 && entry.loads == 0) continue;
+            bool resident = entry.texture.id != 0;
+            DrawText(TextFormat("%7.1f KB  %s%s  x%d", entry.bytes / 1024.0, entry.path.c_str(),
+                entry.missing ? " (missing)" : resident ? "" : " (evicted)", entry.loads),
+                x, y, 16, resident ? LIGHTGRAY : GRAY);
+            y += 18;
+        }
+    }
+};
+
+TextureCache& Textures() {
+    static TextureCache cache;
+    return cache;
+}
+
+typedef int FrameResource;
+constexpr FrameResource FRAME_BACKBUFFER = 0;
+// Render targets not used for this many frames are unloaded.
+constexpr uint64_t FRAME_TARGET_IDLE_FRAMES = 120;
+
+struct FrameGraphStats {
+    int executed = 0;
+    int skipped = 0;
+    int culled = 0;
+    int targets = 0;
+};
+
+// Per-frame render graph on top of BeginDrawing/EndDrawing. Passes are
+// declared again every frame, each drawing into one render target or the
+// screen and reading any number of targets. Execute() drops the passes
+// nothing on screen depends on, runs the offscreen ones in declaration
+// order and then the screen ones inside a single BeginDrawing/EndDrawing.
+//
+// Transient targets live for one frame. They come from a pool keyed by
+// size when first written and go back after their last reader has run, so
+// transients whose lifetimes do not overlap share one texture, and their
+// contents start out undefined. Persistent targets are kept by name across
+// frames; a pass drawing into one is skipped when its key and the versions
+// of everything it reads are the same as when it last ran.
+class FrameGraph {
+private:
+    struct KeptTarget {
+        RenderTexture2D target{};
+        uint64_t version = 0;
+        uint64_t signature = 0;
+        uint64_t lastUsed = 0;
+        bool written = false;
+    };
+
+    struct PooledTarget {
+        RenderTexture2D target{};
+        uint64_t lastUsed = 0;
+        bool busy = false;
+    };
+
+    struct Resource {
+        const char* name = "";
+        int width = 0;
+        int height = 0;
+        KeptTarget* kept = nullptr;
+        bool fresh = false;
+        int pooled = -1;
+        int lastRead = -1;
+        uint64_t version = 0;
+    };
+
+    struct Pass {
+        const char* name = "";
+        FrameResource output = FRAME_BACKBUFFER;
+        std::vector<FrameResource> inputs;
+        uint64_t key = 0;
+        std::function<void()> execute;
+    };
+
+    std::map<std::string, KeptTarget> kept;
+    std::vector<PooledTarget> pool;
+    std::vector<Resource> resources;
+    std::vector<Pass> passes;
+    uint64_t frame = 1;
+    uint64_t transientVersion = 0;
+    FrameGraphStats stats;
+
+    Resource& At(FrameResource handle) {
+        return resources[handle - 1];
+    }
+
+    int Acquire(int width, int height) {
+        for (size_t i = 0; i < pool.size(); ++i) {
+            PooledTarget& slot = pool[i];
+            if (!slot.busy && slot.target.texture.width == width && slot.target.texture.height == height) {
+                slot.busy = true;
+                slot.lastUsed = frame;
+                return (int)i;
+            }
+        }
+        PooledTarget slot;
+        slot.target = LoadRenderTexture(width, height);
+        slot.busy = true;
+        slot.lastUsed = frame;
+        pool.push_back(slot);
+        return (int)pool.size() - 1;
+    }
+
+    // Mixes a value into a running signature (FNV-1a over its bytes).
+    static uint64_t Mix(uint64_t hash, uint64_t value) {
+        for (int i = 0; i < 8; ++i) {
+            hash ^= (value >> (i * 8)) & 0xFF;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // Runs one pass, the position-th to execute this frame.
+    void Run(int index, int position) {
+        Pass& pass = passes[index];
+        if (pass.output == FRAME_BACKBUFFER) {
+            pass.execute();
+            stats.executed++;
+        }
+        else {
+            Resource& output = At(pass.output);
+            if (output.kept != nullptr) {
+                uint64_t signature = Mix(14695981039346656037ull, pass.key);
+                for (FrameResource input : pass.inputs) signature = Mix(signature, At(input).version);
+
+                KeptTarget& target = *output.kept;
+                if (target.written && target.signature == signature) {
+                    stats.skipped++;
+                }
+                else {
+                    BeginTextureMode(target.target);
+                    pass.execute();
+                    EndTextureMode();
+                    target.signature = signature;
+                    target.written = true;
+                    output.version = ++target.version;
+                    stats.executed++;
+                }
+            }
+            else {
+                if (output.pooled < 0) output.pooled = Acquire(output.width, output.height);
+                BeginTextureMode(pool[output.pooled].target);
+                pass.execute();
+                EndTextureMode();
+                output.version = ++transientVersion;
+                stats.executed++;
+            }
+        }
+
+        // Transients whose last reader this was go back to the pool.
+        for (Resource& resource : resources) {
+            if (resource.pooled >= 0 && resource.lastRead <= position) {
+                pool[resource.pooled].busy = false;
+                resource.pooled = -1;
+            }
+        }
+    }
+
+public:
+    ~FrameGraph() {
+        Release();
+    }
+
+    // A target that exists for this frame only.
+    FrameResource Transient(const char* name, int width, int height) {
+        Resource resource;
+        resource.name = name;
+        resource.width = width;
+        resource.height = height;
+        resources.push_back(resource);
+        return (FrameResource)resources.size();
+    }
+
+    // A target that keeps its contents from frame to frame, created (and
+    // cleared) the first time its name is used at this size.
+    FrameResource Persistent(const char* name, int width, int height) {
+        KeptTarget& target = kept[name];
+        bool fresh = target.target.id == 0 || target.target.texture.width != width || target.target.texture.height != height;
+        if (fresh) {
+            if (target.target.id != 0) UnloadRenderTexture(target.target);
+            target = KeptTarget();
+            target.target = LoadRenderTexture(width, height);
+            BeginTextureMode(target.target);
+            ClearBackground(BLANK);
+            EndTextureMode();
+        }
+        target.lastUsed = frame;
+
+        Resource resource;
+        resource.name = name;
+        resource.width = width;
+        resource.height = height;
+        resource.kept = &target;
+        resource.fresh = fresh;
+        resource.version = target.version;
+        resources.push_back(resource);
+        return (FrameResource)resources.size();
+    }
+
+    // Whether a persistent target was just created, so whatever it held
+    // before has to be drawn again.
+    bool Fresh(FrameResource handle) {
+        return handle != FRAME_BACKBUFFER && At(handle).fresh;
+    }
+
+    // The texture behind a target. A transient one only exists while the
+    // passes between its first writer and its last reader run.
+    RenderTexture2D Target(FrameResource handle) {
+        Resource& resource = At(handle);
+        if (resource.kept != nullptr) return resource.kept->target;
+        return resource.pooled >= 0 ? pool[resource.pooled].target : RenderTexture2D{};
+    }
+
+    void AddPass(const char* name, FrameResource output, std::vector<FrameResource> inputs, uint64_t key, std::function<void()> execute) {
+        Pass pass;
+        pass.name = name;
+        pass.output = output;
+        pass.inputs = std::move(inputs);
+        pass.key = key;
+        pass.execute = std::move(execute);
+        passes.push_back(std::move(pass));
+    }
+
+    // Runs the frame's passes and presents it, then forgets them. Returns
+    // the recorder time just before presenting, where drawing ends.
+    int64_t Execute() {
+        stats = FrameGraphStats();
+
+        // Walking back from the screen, a pass is needed when something
+        // already needed reads what it draws.
+        std::vector<uint8_t> needed(resources.size() + 1, 0);
+        std::vector<int> order;
+        for (int i = (int)passes.size() - 1; i >= 0; --i) {
+            const Pass& pass = passes[i];
+            if (pass.output != FRAME_BACKBUFFER && !needed[pass.output]) {
+                stats.culled++;
+                continue;
+            }
+            order.push_back(i);
+            for (FrameResource input : pass.inputs) needed[input] = 1;
+        }
+        std::reverse(order.begin(), order.end());
+        std::stable_partition(order.begin(), order.end(), [&](int i) { return passes[i].output != FRAME_BACKBUFFER; });
+
+        // Lifetimes are counted in execution order, since the screen passes
+        // run after every offscreen one.
+        std::vector<int> position(passes.size(), -1);
+        for (size_t i = 0; i < order.size(); ++i) position[order[i]] = (int)i;
+        for (int i : order) {
+            for (FrameResource input : passes[i].inputs) {
+                Resource& resource = At(input);
+                resource.lastRead = std::max(resource.lastRead, position[i]);
+            }
+        }
+
+        bool drawing = false;
+        for (size_t i = 0; i < order.size(); ++i) {
+            if (!drawing && passes[order[i]].output == FRAME_BACKBUFFER) {
+                BeginDrawing();
+                drawing = true;
+            }
+            Run(order[i], (int)i);
+        }
+        if (!drawing) BeginDrawing();
+        int64_t presentStart = Recorder().Now();
+        {
+            PROFILE_ZONE("Present");
+            EndDrawing();
+        }
+
+        for (PooledTarget& slot : pool) slot.busy = false;
+        pool.erase(std::remove_if(pool.begin(), pool.end(), [&](const PooledTarget& slot) {
+            if (slot.lastUsed + FRAME_TARGET_IDLE_FRAMES > frame) return false;
+            UnloadRenderTexture(slot.target);
+            return true;
+        }), pool.end());
+        for (auto it = kept.begin(); it != kept.end();) {
+            if (it->second.lastUsed + FRAME_TARGET_IDLE_FRAMES > frame) {
+                ++it;
+                continue;
+            }
+            UnloadRenderTexture(it->second.target);
+            it = kept.erase(it);
+        }
+        stats.targets = (int)(pool.size() + kept.size());
+
+        resources.clear();
+        passes.clear();
+        frame++;
+        return presentStart;
+    }
+
+    const FrameGraphStats& Stats() const {
+        return stats;
+    }
+
+    void Release() {
+        for (const PooledTarget& slot : pool) UnloadRenderTexture(slot.target);
+        for (const auto& entry : kept) UnloadRenderTexture(entry.second.target);
+        pool.clear();
+        kept.clear();
+        resources.clear();
+        passes.clear();
+    }
+};
+
+class Button {
+private:
+    TextureHandle texture;
+    bool wasPressed;
+
+public:
+    Vector2 position;
+
+    Button(const char* imagePath, Vector2 imagePosition, float scale) : wasPressed(false) {
+        texture = Textures().Register(imagePath, scale);
+        position = imagePosition;
+    }
+
+    void Draw() {
+        DrawTextureV(Textures().Get(texture), position, WHITE);
+        drawSubmissions++;
+    }
+
+    bool isClicked(Vector2 mousePos) {
+        Texture2D current = Textures().Get(texture);
+        Rectangle rect = { position.x, position.y, static_cast<float>(current.width), static_cast<float>(current.height) };
+
+        bool isOver = CheckCollisionPointRec(mousePos, rect);
+
+        if (isOver && IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
+            wasPressed = true;
+            return false;
+        }
+
+        if (isOver && wasPressed && IsMouseButtonReleased(MOUSE_BUTTON_LEFT)) {
+            wasPressed = false;
+            return true;
+        }
+
+        if (IsMouseButtonReleased(MOUSE_BUTTON_LEFT)) {
+            wasPressed = false;
+        }
+
+        return false;
+    }
+
+    int getWidth() {
+        return Textures().Get(texture).width;
+    }
+
+    int getHeight() {
+        return Textures().Get(texture).height;
+    }
+};
+
+enum class LevelState {
+    PLAYING,
+    COMPLETED,
+    FAILED
+};
+
+constexpr float BLOCK_GRID_CELL = 32.0f;
+constexpr int BLOCK_GRID_COLUMNS = (int)(WORLD_WIDTH / BLOCK_GRID_CELL);
+constexpr int BLOCK_GRID_ROWS = (int)((WORLD_HEIGHT + BLOCK_GRID_CELL - 1) / BLOCK_GRID_CELL);
+
+// Uniform grid over a list of rectangles; a level's block runs sit in one as
+// the broadphase for bird collisions. Cells keep their indices in ascending
+// order and queries return them sorted. The grid is built once per list and
+// patched as entries come and go. Rectangles outside the world are clamped
+// into the edge cells.
+class BlockGrid {
+private:
+    std::vector<std::vector<uint32_t>> cells;
+    std::vector<uint32_t> candidates;
+    size_t builtFor = SIZE_MAX;
+
+    static int Column(float x) {
+        return std::max(0, std::min(BLOCK_GRID_COLUMNS - 1, (int)std::floor(x / BLOCK_GRID_CELL)));
+    }
+
+    static int Row(float y) {
+        return std::max(0, std::min(BLOCK_GRID_ROWS - 1, (int)std::floor(y / BLOCK_GRID_CELL)));
+    }
+
+    template <class Fn>
+    static void ForEachCell(Rectangle area, Fn fn) {
+        for (int row = Row(area.y); row <= Row(area.y + area.height); ++row) {
+            for (int column = Column(area.x); column <= Column(area.x + area.width); ++column) {
+                fn(row * BLOCK_GRID_COLUMNS + column);
+            }
+        }
+    }
+
+    void Link(uint32_t index, Rectangle rect) {
+        ForEachCell(rect, [&](int cell) {
+            auto& blocks = cells[cell];
+            blocks.insert(std::upper_bound(blocks.begin(), blocks.end(), index), index);
+        });
+    }
+
+    void Unlink(uint32_t index, Rectangle rect) {
+        ForEachCell(rect, [&](int cell) {
+            auto& blocks = cells[cell];
+            auto it = std::lower_bound(blocks.begin(), blocks.end(), index);
+            if (it != blocks.end() && *it == index) blocks.erase(it);
+        });
+    }
+
+public:
+    void Build(const std::vector<Obstacle>& obstacles) {
+        cells.assign(BLOCK_GRID_COLUMNS * BLOCK_GRID_ROWS, {});
+        for (size_t i = 0; i < obstacles.size(); ++i) {
+            ForEachCell(obstacles[i].rect, [&](int cell) { cells[cell].push_back((uint32_t)i); });
+        }
+        builtFor = obstacles.size();
+    }
+
+    // Drops the grid; edits are ignored until the next build.
+    void Invalidate() {
+        builtFor = SIZE_MAX;
+    }
+
+    // Edits made to the obstacle list, mirrored so the grid does not have to
+    // be rebuilt. Ignored until the grid has been built once.
+    void Insert(uint32_t index, Rectangle rect) {
+        if (builtFor == SIZE_MAX) return;
+        Link(index, rect);
+        builtFor++;
+    }
+
+    void Remove(uint32_t index, Rectangle rect) {
+        if (builtFor == SIZE_MAX) return;
+        Unlink(index, rect);
+        builtFor--;
+    }
+
+    void Renumber(uint32_t from, uint32_t to, Rectangle rect) {
+        if (builtFor == SIZE_MAX) return;
+        Unlink(from, rect);
+        Link(to, rect);
+    }
+
+    // Indices of the entries whose cells overlap area, ascending and without
+    // repeats. Rebuilds first if the list was replaced.
+    const std::vector<uint32_t>& Query(const std::vector<Obstacle>& obstacles, Rectangle area) {
+        if (builtFor != obstacles.size()) Build(obstacles);
+
+        candidates.clear();
+        ForEachCell(area, [&](int cell) {
+            candidates.insert(candidates.end(), cells[cell].begin(), cells[cell].end());
+        });
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+        return candidates;
+    }
+};
+
+// Probe points are rounded sums that can land a hair outside the bird's
+// bounding box, so run bounds are tested against a box this much larger.
+constexpr float BLOCK_RUN_QUERY_MARGIN = 1.0f;
+constexpr uint32_t NO_BLOCK_RUN = UINT32_MAX;
+
+// Intact blocks merged into runs. Blocks of the same size and colours that
+// touch edge to edge form rows, and rows over the same columns that sit on
+// one another form a single rectangle. A run is one entry in the broadphase
+// and one quad plus its seams when drawn. Destroying a block carves what is
+// left of its run into smaller runs, and hot-reload edits are patched in
+// the same way. Anything else that changes which blocks are intact
+// invalidates the runs and they are rebuilt on next use.
+class BlockRuns {
+private:
+    struct Run {
+        // Members row by row, top row first.
+        std::vector<uint32_t> blocks;
+        int columns = 0;
+        // Far edges as the members compute them, for exact bounds tests.
+        float right = 0.0f;
+        float bottom = 0.0f;
+    };
+
+    std::vector<Obstacle> quads;
+    std::vector<Run> runs;
+    std::vector<uint32_t> runOf;
+    BlockGrid grid;
+    std::vector<uint32_t> candidates;
+    size_t builtFor = SIZE_MAX;
+
+    static uint64_t Colors(const Obstacle& obs) {
+        uint32_t fill, stroke;
+        memcpy(&fill, &obs.fillColor, sizeof(fill));
+        memcpy(&stroke, &obs.strokeColor, sizeof(stroke));
+        return (uint64_t)fill << 32 | stroke;
+    }
+
+    static bool SameKind(const Obstacle& a, const Obstacle& b) {
+        return Colors(a) == Colors(b) && a.rect.width == b.rect.width && a.rect.height == b.rect.height;
+    }
+
+    // The first position in [from, to) where past no longer holds; past is
+    // true for a prefix of the range.
+    template <class Fn>
+    static int FirstNot(int from, int to, Fn past) {
+        while (from < to) {
+            int middle = from + (to - from) / 2;
+            if (past(middle)) from = middle + 1;
+            else to = middle;
+        }
+        return from;
+    }
+
+    static bool KindBefore(const Obstacle& a, const Obstacle& b) {
+        if (Colors(a) != Colors(b)) return Colors(a) < Colors(b);
+        if (a.rect.width != b.rect.width) return a.rect.width < b.rect.width;
+        return a.rect.height < b.rect.height;
+    }
+
+    void Add(const std::vector<Obstacle>& obstacles, Run run) {
+        const Obstacle& first = obstacles[run.blocks.front()];
+        const Obstacle& last = obstacles[run.blocks.back()];
+        run.right = last.rect.x + last.rect.width;
+        run.bottom = last.rect.y + last.rect.height;
+
+        uint32_t index = (uint32_t)runs.size();
+        Rectangle rect = { first.rect.x, first.rect.y, run.right - first.rect.x, run.bottom - first.rect.y };
+        quads.push_back(Obstacle(rect, true, first.fillColor, first.strokeColor));
+        for (uint32_t block : run.blocks) runOf[block] = index;
+        runs.push_back(std::move(run));
+        grid.Insert(index, rect);
+    }
+
+    // Greedy merge of the given intact blocks into new runs.
+    void Merge(const std::vector<Obstacle>& obstacles, std::vector<uint32_t> blocks) {
+        auto finite = [&](uint32_t i) {
+            const Rectangle& r = obstacles[i].rect;
+            return std::isfinite(r.x) && std::isfinite(r.y) && std::isfinite(r.width) && std::isfinite(r.height);
+        };
+        auto odd = std::stable_partition(blocks.begin(), blocks.end(), finite);
+        for (auto it = odd; it != blocks.end(); ++it) Add(obstacles, Run{ { *it }, 1 });
+        blocks.erase(odd, blocks.end());
+
+        // Rows: same kind and height, each block starting where the last ended.
+        std::sort(blocks.begin(), blocks.end(), [&](uint32_t a, uint32_t b) {
+            const Obstacle& oa = obstacles[a];
+            const Obstacle& ob = obstacles[b];
+            if (KindBefore(oa, ob) || KindBefore(ob, oa)) return KindBefore(oa, ob);
+            if (oa.rect.y != ob.rect.y) return oa.rect.y < ob.rect.y;
+            if (oa.rect.x != ob.rect.x) return oa.rect.x < ob.rect.x;
+            return a < b;
+        });
+        std::vector<Run> rows;
+        for (uint32_t block : blocks) {
+            if (!rows.empty()) {
+                const Obstacle& last = obstacles[rows.back().blocks.back()];
+                const Obstacle& next = obstacles[block];
+                if (SameKind(last, next) && last.rect.y == next.rect.y && last.rect.x + last.rect.width == next.rect.x) {
+                    rows.back().blocks.push_back(block);
+                    rows.back().columns++;
+                    continue;
+                }
+            }
+            rows.push_back(Run{ { block }, 1 });
+        }
+
+        // Columns: rows of the same kind, start and length stacked edge to edge.
+        std::sort(rows.begin(), rows.end(), [&](const Run& a, const Run& b) {
+            const Obstacle& oa = obstacles[a.blocks.front()];
+            const Obstacle& ob = obstacles[b.blocks.front()];
+            if (KindBefore(oa, ob) || KindBefore(ob, oa)) return KindBefore(oa, ob);
+            if (oa.rect.x != ob.rect.x) return oa.rect.x < ob.rect.x;
+            if (a.columns != b.columns) return a.columns < b.columns;
+            if (oa.rect.y != ob.rect.y) return oa.rect.y < ob.rect.y;
+            return a.blocks.front() < b.blocks.front();
+        });
+        Run run;
+        for (Run& row : rows) {
+            if (!run.blocks.empty()) {
+                const Obstacle& last = obstacles[run.blocks.back()];
+                const Obstacle& next = obstacles[row.blocks.front()];
+                const Obstacle& top = obstacles[run.blocks.front()];
+                if (SameKind(last, next) && top.rect.x == next.rect.x && run.columns == row.columns &&
+                    last.rect.y + last.rect.height == next.rect.y) {
+                    run.blocks.insert(run.blocks.end(), row.blocks.begin(), row.blocks.end());
+                    continue;
+                }
+                Add(obstacles, std::move(run));
+            }
+            run = std::move(row);
+        }
+        if (!run.blocks.empty()) Add(obstacles, std::move(run));
+    }
+
+public:
+    void Invalidate() {
+        builtFor = SIZE_MAX;
+    }
+
+    void Build(const std::vector<Obstacle>& obstacles) {
+        quads.clear();
+        runs.clear();
+        runOf.assign(obstacles.size(), NO_BLOCK_RUN);
+
+        std::vector<uint32_t> intact;
+        for (size_t i = 0; i < obstacles.size(); ++i) {
+            if (obstacles[i].visible) intact.push_back((uint32_t)i);
+        }
+        grid.Invalidate();
+        Merge(obstacles, std::move(intact));
+        grid.Build(quads);
+        builtFor = obstacles.size();
+    }
+
+    // Takes a block out of its run. The rest of the run is carved into at
+    // most four runs: the rows above, the rows below, and the parts of the
+    // block's row left and right of it.
+    void Split(const std::vector<Obstacle>& obstacles, uint32_t block) {
+        if (builtFor != obstacles.size() || runOf[block] == NO_BLOCK_RUN) return;
+
+        uint32_t index = runOf[block];
+        Run run = std::move(runs[index]);
+        runOf[block] = NO_BLOCK_RUN;
+
+        uint32_t last = (uint32_t)runs.size() - 1;
+        grid.Remove(index, quads[index].rect);
+        if (index != last) {
+            grid.Renumber(last, index, quads[last].rect);
+            quads[index] = quads[last];
+            runs[index] = std::move(runs[last]);
+            for (uint32_t member : runs[index].blocks) runOf[member] = index;
+        }
+        quads.pop_back();
+        runs.pop_back();
+
+        int at = (int)(std::find(run.blocks.begin(), run.blocks.end(), block) - run.blocks.begin());
+        int row = at / run.columns;
+        int column = at % run.columns;
+        int rows = (int)run.blocks.size() / run.columns;
+        auto carve = [&](int firstRow, int endRow, int firstColumn, int endColumn) {
+            if (firstRow >= endRow || firstColumn >= endColumn) return;
+            Run part;
+            part.columns = endColumn - firstColumn;
+            for (int r = firstRow; r < endRow; ++r) {
+                auto start = run.blocks.begin() + r * run.columns;
+                part.blocks.insert(part.blocks.end(), start + firstColumn, start + endColumn);
+            }
+            Add(obstacles, std::move(part));
+        };
+        carve(0, row, 0, run.columns);
+        carve(row, row + 1, 0, column);
+        carve(row, row + 1, column + 1, run.columns);
+        carve(row + 1, rows, 0, run.columns);
+    }
+
+    // A block is about to be removed from the list by moving the last block
+    // into its place. Takes it out of its run and renumbers the last one.
+    void Remove(const std::vector<Obstacle>& obstacles, uint32_t index) {
+        if (builtFor != obstacles.size()) return;
+        Split(obstacles, index);
+
+        uint32_t last = (uint32_t)obstacles.size() - 1;
+        if (index != last && runOf[last] != NO_BLOCK_RUN) {
+            Run& run = runs[runOf[last]];
+            *std::find(run.blocks.begin(), run.blocks.end(), last) = index;
+        }
+        runOf[index] = runOf[last];
+        runOf.pop_back();
+        builtFor--;
+    }
+
+    // Merges blocks that were added after the first previousCount, or moved
+    // after being split out, into new runs among themselves.
+    void Insert(const std::vector<Obstacle>& obstacles, size_t previousCount, std::vector<uint32_t> blocks) {
+        if (builtFor != previousCount) return;
+        runOf.resize(obstacles.size(), NO_BLOCK_RUN);
+        builtFor = obstacles.size();
+        blocks.erase(std::remove_if(blocks.begin(), blocks.end(), [&](uint32_t block) {
+            return !obstacles[block].visible;
+        }), blocks.end());
+        Merge(obstacles, std::move(blocks));
+    }
+
+    // Intact blocks that overlap area, ascending, so collisions resolve in
+    // the same order as a scan over every block. Only the columns and rows
+    // of a run that reach into area are taken.
+    const std::vector<uint32_t>& Query(const std::vector<Obstacle>& obstacles, Rectangle area) {
+        if (builtFor != obstacles.size()) Build(obstacles);
+
+        Rectangle padded = { area.x - BLOCK_RUN_QUERY_MARGIN, area.y - BLOCK_RUN_QUERY_MARGIN,
+            area.width + 2 * BLOCK_RUN_QUERY_MARGIN, area.height + 2 * BLOCK_RUN_QUERY_MARGIN };
+        float paddedRight = padded.x + padded.width;
+        float paddedBottom = padded.y + padded.height;
+        candidates.clear();
+        for (uint32_t index : grid.Query(quads, padded)) {
+            const Rectangle& rect = quads[index].rect;
+            const Run& run = runs[index];
+            if (rect.x > paddedRight || run.right < padded.x || rect.y > paddedBottom || run.bottom < padded.y) continue;
+
+            auto column = [&](int c) -> const Rectangle& { return obstacles[run.blocks[c]].rect; };
+            auto row = [&](int r) -> const Rectangle& { return obstacles[run.blocks[r * run.columns]].rect; };
+            int rows = (int)run.blocks.size() / run.columns;
+            int firstColumn = FirstNot(0, run.columns, [&](int c) { return column(c).x + column(c).width < padded.x; });
+            int endColumn = FirstNot(firstColumn, run.columns, [&](int c) { return column(c).x <= paddedRight; });
+            int firstRow = FirstNot(0, rows, [&](int r) { return row(r).y + row(r).height < padded.y; });
+            int endRow = FirstNot(firstRow, rows, [&](int r) { return row(r).y <= paddedBottom; });
+            for (int r = firstRow; r < endRow; ++r) {
+                auto start = run.blocks.begin() + r * run.columns;
+                candidates.insert(candidates.end(), start + firstColumn, start + endColumn);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end());
+        return candidates;
+    }
+
+    // Each run as one quad with its outline, then the seams between its
+    // members as wide as the two block strokes either side of them.
+    void Draw(const std::vector<Obstacle>& obstacles) {
+        if (builtFor != obstacles.size()) Build(obstacles);
+
+        for (size_t i = 0; i < runs.size(); ++i) {
+            const Obstacle& quad = quads[i];
+            const Run& run = runs[i];
+            int rows = (int)run.blocks.size() / run.columns;
+            quad.Draw();
+            for (int column = 1; column < run.columns; ++column) {
+                float x = obstacles[run.blocks[column]].rect.x;
+                DrawRectangleRec({ x - 2, quad.rect.y, 4, quad.rect.height }, quad.strokeColor);
+            }
+            for (int row = 1; row < rows; ++row) {
+                float y = obstacles[run.blocks[row * run.columns]].rect.y;
+                DrawRectangleRec({ quad.rect.x, y - 2, quad.rect.width, 4 }, quad.strokeColor);
+            }
+            drawSubmissions += run.columns - 1 + rows - 1;
+        }
+    }
+
+    size_t Count() const {
+        return runs.size();
+    }
+};
+
+class Level {
+public:
+    uint32_t id = 0;
+    std::vector<Obstacle> obstacles;
+    std::string name;
+    int targetScore = 0;
+    LevelState state = LevelState::PLAYING;
+
+    std::array<BirdType, BIRDS_PER_LEVEL> birds{};
+
+    BlockRuns runs;
+    // Narrowphase tests since the counter was last cleared.
+    uint32_t pairTests = 0;
+
+    void Reset() {
+        for (auto& obs : obstacles) {
+            obs.visible = true;
+        }
+        runs.Invalidate();
+        state = LevelState::PLAYING;
+    }
+
+    void Destroy(uint32_t index) {
+        obstacles[index].visible = false;
+        runs.Split(obstacles, index);
+    }
+
+    int GetCurrentScore() const {
+        int score = 0;
+        for (const auto& obs : obstacles) {
+            if (!obs.visible) {
+                score += 10;
+            }
+        }
+        return score;
+    }
+
+    void Update() {
+        if (GetCurrentScore() >= targetScore) {
+            state = LevelState::COMPLETED;
+        }
+    }
+};
+
+// The level blob: the layout only, not the id, name or play state.
+template <>
+struct Reflect<Level> {
+    using Fields = FieldList<Field<&Level::targetScore>, Field<&Level::birds>, Field<&Level::obstacles>>;
+};
+
+Color ColorFromHex(unsigned int rgba) {
+    return { (unsigned char)(rgba >> 24), (unsigned char)(rgba >> 16), (unsigned char)(rgba >> 8), (unsigned char)rgba };
+}
+
+unsigned int HexFromColor(Color color) {
+    return ((unsigned int)color.r << 24) | ((unsigned int)color.g << 16) | ((unsigned int)color.b << 8) | color.a;
+}
+
+// Changes between a level's blocks and an edited copy of them. Blocks have
+// no identity of their own: one identical in position, size and colours is
+// unchanged, one with the same size and colours somewhere else has moved,
+// and the rest are removed or inserted.
+struct LevelDiff {
+    std::vector<std::pair<uint32_t, Rectangle>> moves;
+    std::vector<uint32_t> removes;
+    std::vector<Obstacle> inserts;
+
+    bool Empty() const {
+        return moves.empty() && removes.empty() && inserts.empty();
+    }
+};
+
+LevelDiff DiffObstacles(const std::vector<Obstacle>& current, const std::vector<Obstacle>& edited) {
+    // Position, size and colours, each packed into 64 bits.
+    typedef std::array<uint64_t, 3> BlockKey;
+    auto keyOf = [](const Obstacle& obs, bool withPosition) {
+        auto pack = [](float a, float b) {
+            uint32_t bitsA, bitsB;
+            memcpy(&bitsA, &a, sizeof(a));
+            memcpy(&bitsB, &b, sizeof(b));
+            return (uint64_t)bitsA << 32 | bitsB;
+        };
+        BlockKey key;
+        key[0] = withPosition ? pack(obs.rect.x, obs.rect.y) : 0;
+        key[1] = pack(obs.rect.width, obs.rect.height);
+        key[2] = (uint64_t)HexFromColor(obs.fillColor) << 32 | HexFromColor(obs.strokeColor);
+        return key;
+    };
+
+    // Pairs up blocks with equal keys from two sorted lists; whatever is left
+    // over on either side stays in the lists.
+    typedef std::vector<std::pair<BlockKey, uint32_t>> KeyedBlocks;
+    auto match = [](KeyedBlocks& a, KeyedBlocks& b, auto onPair) {
+        std::sort(a.begin(), a.end());
+        std::sort(b.begin(), b.end());
+        KeyedBlocks restA, restB;
+        size_t i = 0, j = 0;
+        while (i < a.size() || j < b.size()) {
+            if (j == b.size() || (i < a.size() && a[i].first < b[j].first)) restA.push_back(a[i++]);
+            else if (i == a.size() || b[j].first < a[i].first) restB.push_back(b[j++]);
+            else onPair(a[i++].second, b[j++].second);
+        }
+        a.swap(restA);
+        b.swap(restB);
+    };
+
+    // Editors usually write blocks back in the same order, so only the span
+    // between the unchanged head and tail needs matching.
+    size_t head = 0, tail = 0;
+    size_t common = std::min(current.size(), edited.size());
+    while (head < common && keyOf(current[head], true) == keyOf(edited[head], true)) head++;
+    while (tail < common - head &&
+        keyOf(current[current.size() - 1 - tail], true) == keyOf(edited[edited.size() - 1 - tail], true)) tail++;
+
+    KeyedBlocks before, after;
+    for (uint32_t i = (uint32_t)head; i < current.size() - tail; ++i) before.push_back({ keyOf(current[i], true), i });
+    for (uint32_t i = (uint32_t)head; i < edited.size() - tail; ++i) after.push_back({ keyOf(edited[i], true), i });
+    match(before, after, [](uint32_t, uint32_t) {});
+
+    for (auto& block : before) block.first = keyOf(current[block.second], false);
+    for (auto& block : after) block.first = keyOf(edited[block.second], false);
+
+    LevelDiff diff;
+    match(before, after, [&](uint32_t from, uint32_t to) {
+        diff.moves.push_back({ from, edited[to].rect });
+    });
+    for (const auto& block : before) diff.removes.push_back(block.second);
+    for (const auto& block : after) diff.inserts.push_back(edited[block.second]);
+    return diff;
+}
+
+// Applies a diff to the level's blocks and runs in place. Moved blocks keep
+// whether they were destroyed; removals swap the last block into the gap.
+void ApplyLevelDiff(Level& level, const LevelDiff& diff) {
+    std::vector<uint32_t> merge;
+    for (const auto& move : diff.moves) {
+        level.runs.Split(level.obstacles, move.first);
+        level.obstacles[move.first].rect = move.second;
+        merge.push_back(move.first);
+    }
+
+    std::vector<uint32_t> removes = diff.removes;
+    std::sort(removes.begin(), removes.end(), std::greater<uint32_t>());
+    for (uint32_t index : removes) {
+        uint32_t last = (uint32_t)level.obstacles.size() - 1;
+        level.runs.Remove(level.obstacles, index);
+        if (index != last) {
+            level.obstacles[index] = level.obstacles[last];
+            std::replace(merge.begin(), merge.end(), last, index);
+        }
+        level.obstacles.pop_back();
+    }
+
+    size_t previousCount = level.obstacles.size();
+    for (const Obstacle& obs : diff.inserts) {
+        merge.push_back((uint32_t)level.obstacles.size());
+        level.obstacles.push_back(obs);
+    }
+    level.runs.Insert(level.obstacles, previousCount, std::move(merge));
+}
+
+
+constexpr float GROUND_Y = WORLD_HEIGHT - 40;
+
+// Compile-time level builder. Built-in layouts are constexpr functions that
+// fill a fixed-size table; a layout that overflows or underfills its table,
+// or puts a block outside the world, fails the build.
+template <size_t N>
+class LevelLayout {
+public:
+    std::array<Obstacle, N> obstacles{};
+    size_t count = 0;
+
+    constexpr void Block(float x, float y, float width, float height, Color fill, Color stroke) {
+        obstacles[count++] = Obstacle({ x, y, width, height }, true, fill, stroke);
+    }
+
+    constexpr void Row(float startX, float y, int blocks, float spacing, float width, float height, Color fill, Color stroke) {
+        for (int i = 0; i < blocks; ++i) {
+            Block(startX + i * spacing, y, width, height, fill, stroke);
+        }
+    }
+
+    // Outline of a size x size square standing on baseY, bottom row first.
+    constexpr void HollowSquare(float centerX, float baseY, int size, float blockSize, Color fill, Color stroke) {
+        float offset = (size * blockSize) / 2.0f;
+
+        for (int i = 0; i < size; i++) {
+            Block(centerX - offset + (i * blockSize), baseY, blockSize, blockSize, fill, stroke);
+            Block(centerX - offset + (i * blockSize), baseY - (size - 1) * blockSize, blockSize, blockSize, fill, stroke);
+
+            if (i > 0 && i < size - 1) {
+                Block(centerX - offset, baseY - (i * blockSize), blockSize, blockSize, fill, stroke);
+                Block(centerX + offset - blockSize, baseY - (i * blockSize), blockSize, blockSize, fill, stroke);
+            }
+        }
+    }
+
+    constexpr bool Complete() const {
+        return count == N;
+    }
+
+    constexpr bool InsideWorld() const {
+        for (const Obstacle& obs : obstacles) {
+            if (obs.rect.width <= 0 || obs.rect.height <= 0 || obs.rect.x < 0 || obs.rect.y < 0 ||
+                obs.rect.x + obs.rect.width > WORLD_WIDTH || obs.rect.y + obs.rect.height > GROUND_Y) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+constexpr LevelLayout<25> BuildLevel1() {
+    LevelLayout<25> layout;
+
+    const float centerX = 800.0f;
+    const float blockWidth = 30.0f;
+    const float blockHeight = 40.0f;
+    const float blockSpacing = 35.0f;
+
+    layout.Row(centerX - ((9 - 1) * blockSpacing / 2), GROUND_Y - blockHeight, 9, blockSpacing, blockWidth, blockHeight, GREEN, DARKGREEN);
+    layout.Row(centerX - ((7 - 1) * blockSpacing / 2), GROUND_Y - blockHeight * 2, 7, blockSpacing, blockWidth, blockHeight, YELLOW, GOLD);
+    layout.Row(centerX - ((5 - 1) * blockSpacing / 2), GROUND_Y - blockHeight * 3, 5, blockSpacing, blockWidth, blockHeight, ORANGE, BROWN);
+    layout.Row(centerX - ((3 - 1) * blockSpacing / 2), GROUND_Y - blockHeight * 4, 3, blockSpacing, blockWidth, blockHeight, BLUE, DARKBLUE);
+    layout.Block(centerX - blockWidth / 2, GROUND_Y - blockHeight * 5, blockWidth, blockHeight, RED, MAROON);
+
+    return layout;
+}
+
+constexpr LevelLayout<57> BuildLevel2() {
+    LevelLayout<57> layout;
+
+    const float blockSize = 40.0f;
+    const float smallBlockSize = 20.0f;
+    const float castleBaseX = 700.0f;
+
+    for (int i = 0; i < 8; i++) {
+        layout.Block(castleBaseX + i * blockSize, GROUND_Y - blockSize, blockSize, blockSize, GRAY, DARKGRAY);
+        layout.Block(castleBaseX + i * blockSize, GROUND_Y - 2 * blockSize, blockSize, blockSize, GRAY, DARKGRAY);
+    }
+
+    for (int level = 3; level <= 5; level++) {
+        layout.Block(castleBaseX, GROUND_Y - level * blockSize, blockSize, blockSize, SKYBLUE, DARKBLUE);
+    }
+    for (int level = 3; level <= 5; level++) {
+        layout.Block(castleBaseX + 7 * blockSize, GROUND_Y - level * blockSize, blockSize, blockSize, SKYBLUE, DARKBLUE);
+    }
+
+    for (int i = 1; i < 7; i++) {
+        if (i == 3 || i == 4) continue;
+        layout.Block(castleBaseX + i * blockSize, GROUND_Y - 3 * blockSize, blockSize, blockSize, SKYBLUE, DARKBLUE);
+        layout.Block(castleBaseX + i * blockSize, GROUND_Y - 4 * blockSize, blockSize, blockSize, SKYBLUE, DARKBLUE);
+    }
+
+    layout.Row(castleBaseX, GROUND_Y - 5 * blockSize, 8, blockSize, blockSize, blockSize, SKYBLUE, DARKBLUE);
+
+    layout.Block(castleBaseX, GROUND_Y - 6 * blockSize, blockSize, blockSize, SKYBLUE, DARKBLUE);
+    layout.Block(castleBaseX, GROUND_Y - 7 * blockSize, blockSize, blockSize, SKYBLUE, DARKBLUE);
+    layout.Block(castleBaseX + 7 * blockSize, GROUND_Y - 6 * blockSize, blockSize, blockSize, SKYBLUE, DARKBLUE);
+    layout.Block(castleBaseX + 7 * blockSize, GROUND_Y - 7 * blockSize, blockSize, blockSize, SKYBLUE, DARKBLUE);
+    layout.Block(castleBaseX + 2 * blockSize, GROUND_Y - 6 * blockSize, blockSize, blockSize, SKYBLUE, DARKBLUE);
+    layout.Block(castleBaseX + 5 * blockSize, GROUND_Y - 6 * blockSize, blockSize, blockSize, SKYBLUE, DARKBLUE);
+
+    for (int i = 0; i < 8; i++) {
+        if (i != 1 && i != 3 && i != 4 && i != 6) {
+            layout.Block(castleBaseX + i * blockSize, GROUND_Y - 7 * blockSize, blockSize, blockSize, SKYBLUE, DARKBLUE);
+        }
+    }
+
+    layout.Block(castleBaseX + 3 * blockSize, GROUND_Y - 6 * blockSize, 2 * blockSize, blockSize, BLUE, DARKBLUE);
+    layout.Block(castleBaseX + 3 * blockSize, GROUND_Y - 7 * blockSize, 2 * blockSize, blockSize, BLUE, DARKBLUE);
+    layout.Block(castleBaseX + 3 * blockSize, GROUND_Y - 8 * blockSize, 2 * blockSize, blockSize, BLUE, DARKBLUE);
+    layout.Block(castleBaseX + 3 * blockSize, GROUND_Y - 9 * blockSize, 2 * blockSize, blockSize, PURPLE, DARKPURPLE);
+
+    layout.Block(castleBaseX - blockSize, GROUND_Y - blockSize, blockSize, blockSize, DARKGRAY, BLACK);
+    layout.Block(castleBaseX - blockSize, GROUND_Y - 2 * blockSize, blockSize, blockSize, DARKGRAY, BLACK);
+    layout.Block(castleBaseX + 8 * blockSize, GROUND_Y - blockSize, blockSize, blockSize, DARKGRAY, BLACK);
+    layout.Block(castleBaseX + 8 * blockSize, GROUND_Y - 2 * blockSize, blockSize, blockSize, DARKGRAY, BLACK);
+
+    layout.Block(castleBaseX + 3.5f * blockSize - smallBlockSize, GROUND_Y - 7.5f * blockSize, smallBlockSize * 2, smallBlockSize * 2, SKYBLUE, BLUE);
+
+    return layout;
+}
+
+constexpr LevelLayout<121> BuildLevel3() {
+    LevelLayout<121> layout;
+
+    const float centerX = 800.0f;
+    const float baseY = GROUND_Y - 40.0f;
+    const float blockSize = 40.0f;
+
+    layout.HollowSquare(centerX, baseY, 11, blockSize, BLACK, BLACK);
+    layout.HollowSquare(centerX, baseY - blockSize, 9, blockSize, DARKGRAY, BLACK);
+    layout.HollowSquare(centerX, baseY - 2 * blockSize, 7, blockSize, GRAY, DARKGRAY);
+    layout.HollowSquare(centerX, baseY - 3 * blockSize, 5, blockSize, DARKBLUE, BLACK);
+    layout.HollowSquare(centerX, baseY - 4 * blockSize, 3, blockSize, BLUE, DARKBLUE);
+    layout.Block(centerX - blockSize / 2, baseY - 5 * blockSize - blockSize / 2, blockSize, blockSize, GOLD, ORANGE);
+
+    return layout;
+}
+
+constexpr LevelLayout<63> BuildLevel4() {
+    LevelLayout<63> layout;
+
+    const float blockSize = 40.0f;
+    const float leftTowerX = 700.0f;
+    const float rightTowerX = 900.0f;
+    const int towerHeight = 10;
+    const int towerWidth = 3;
+
+    for (int height = 0; height < towerHeight; height++) {
+        layout.Row(leftTowerX, GROUND_Y - (height + 1) * blockSize, towerWidth, blockSize, blockSize, blockSize, BLUE, DARKBLUE);
+    }
+    for (int height = 0; height < towerHeight; height++) {
+        layout.Row(rightTowerX, GROUND_Y - (height + 1) * blockSize, towerWidth, blockSize, blockSize, blockSize, BLUE, DARKBLUE);
+    }
+
+    int platformLength = (int)((rightTowerX - (leftTowerX + towerWidth * blockSize)) / blockSize);
+    layout.Row(leftTowerX + towerWidth * blockSize, GROUND_Y - towerHeight * blockSize, platformLength, blockSize, blockSize, blockSize, BLUE, DARKBLUE);
+
+    float centerX = leftTowerX + towerWidth * blockSize + (platformLength * blockSize) / 2.0f - blockSize / 2.0f;
+    layout.Block(centerX, GROUND_Y - (towerHeight + 1) * blockSize, blockSize, blockSize, GOLD, ORANGE);
+
+    return layout;
+}
+
+constexpr LevelLayout<25> LEVEL1_LAYOUT = BuildLevel1();
+constexpr LevelLayout<57> LEVEL2_LAYOUT = BuildLevel2();
+constexpr LevelLayout<121> LEVEL3_LAYOUT = BuildLevel3();
+constexpr LevelLayout<63> LEVEL4_LAYOUT = BuildLevel4();
+
+static_assert(LEVEL1_LAYOUT.Complete() && LEVEL1_LAYOUT.InsideWorld(), "level 1 layout");
+static_assert(LEVEL2_LAYOUT.Complete() && LEVEL2_LAYOUT.InsideWorld(), "level 2 layout");
+static_assert(LEVEL3_LAYOUT.Complete() && LEVEL3_LAYOUT.InsideWorld(), "level 3 layout");
+static_assert(LEVEL4_LAYOUT.Complete() && LEVEL4_LAYOUT.InsideWorld(), "level 4 layout");
+
+struct BuiltinLevel {
+    uint32_t id;
+    const char* name;
+    int targetScore;
+    std::array<BirdType, BIRDS_PER_LEVEL> birds;
+    const Obstacle* obstacles;
+    size_t obstacleCount;
+};
+
+constexpr BuiltinLevel BUILTIN_LEVELS[] = {
+    { 1, "Starter Tower", 100, { BirdType::NORMAL, BirdType::NORMAL, BirdType::NORMAL },
+        LEVEL1_LAYOUT.obstacles.data(), LEVEL1_LAYOUT.obstacles.size() },
+    { 2, "Fortified Castle", 150, { BirdType::NORMAL, BirdType::NORMAL, BirdType::NORMAL },
+        LEVEL2_LAYOUT.obstacles.data(), LEVEL2_LAYOUT.obstacles.size() },
+    { 3, "Stronghold", 250, { BirdType::NORMAL, BirdType::NORMAL, BirdType::NORMAL },
+        LEVEL3_LAYOUT.obstacles.data(), LEVEL3_LAYOUT.obstacles.size() },
+    { 4, "Ultimate Challenge", 250, { BirdType::NORMAL, BirdType::NORMAL, BirdType::NORMAL },
+        LEVEL4_LAYOUT.obstacles.data(), LEVEL4_LAYOUT.obstacles.size() }
+};
+
+// Level packs hold any number of levels in one file: a header, the
+// compressed level blobs and thumbnails, then an index sorted by id. The
+// index is read in place from a memory mapping, so finding a level is a
+// binary search and nothing is decompressed until the level is played or
+// its thumbnail shown.
+// Header: u32 magic, u16 version, u16 0, u32 level count, u32 index offset.
+// Index entry: u32 id, char name[36], u32 data offset, u32 data size,
+// u32 raw size, u32 thumbnail offset, u32 thumbnail size, u32 checksum.
+constexpr uint32_t LEVEL_PACK_MAGIC = 0x4B504241;
+constexpr uint16_t LEVEL_PACK_VERSION = 1;
+constexpr size_t LEVEL_PACK_HEADER_BYTES = 16;
+constexpr size_t LEVEL_PACK_ENTRY_BYTES = 64;
+constexpr size_t LEVEL_NAME_BYTES = 36;
+constexpr uint32_t LEVEL_MAX_OBSTACLES = 1 << 16;
+constexpr int THUMBNAIL_WIDTH = 192;
+constexpr int THUMBNAIL_HEIGHT = 108;
+
+struct LevelPackEntry {
+    uint32_t id = 0;
+    std::string name;
+    uint32_t dataOffset = 0;
+    uint32_t dataSize = 0;
+    uint32_t rawSize = 0;
+    uint32_t thumbnailOffset = 0;
+    uint32_t thumbnailSize = 0;
+    uint32_t checksum = 0;
+};
+
+void WriteLevelPackEntry(ByteWriter& writer, const LevelPackEntry& entry) {
+    writer.U32(entry.id);
+    for (size_t i = 0; i < LEVEL_NAME_BYTES; ++i) {
+        writer.U8(i + 1 < LEVEL_NAME_BYTES && i < entry.name.size() ? (uint8_t)entry.name[i] : 0);
+    }
+    writer.U32(entry.dataOffset);
+    writer.U32(entry.dataSize);
+    writer.U32(entry.rawSize);
+    writer.U32(entry.thumbnailOffset);
+    writer.U32(entry.thumbnailSize);
+    writer.U32(entry.checksum);
+}
+
+LevelPackEntry ReadLevelPackEntry(ByteReader& reader) {
+    LevelPackEntry entry;
+    entry.id = reader.U32();
+    for (size_t i = 0; i < LEVEL_NAME_BYTES; ++i) {
+        char c = (char)reader.U8();
+        if (c != 0 && entry.name.size() == i) entry.name.push_back(c);
+    }
+    entry.dataOffset = reader.U32();
+    entry.dataSize = reader.U32();
+    entry.rawSize = reader.U32();
+    entry.thumbnailOffset = reader.U32();
+    entry.thumbnailSize = reader.U32();
+    entry.checksum = reader.U32();
+    return entry;
+}
+
+uint32_t LevelChecksum(const uint8_t* data, size_t size) {
+    return (uint32_t)HashBytes(HASH_SEED, data, size);
+}
+
+// Level blob: i32 target score, u8 bird per lineup slot, VarU32 obstacle
+// count, then per obstacle f32 x, y, width, height and RGBA fill and stroke.
+std::vector<uint8_t> EncodeLevel(const Level& level) {
+    ByteWriter writer;
+    Serialize(writer, level);
+    return writer.bytes;
+}
+
+bool DecodeLevel(const uint8_t* data, size_t size, Level& level) {
+    ByteReader reader(data, size);
+    level.obstacles.clear();
+    if (!Deserialize(reader, level) || reader.Remaining() != 0) return false;
+    for (BirdType bird : level.birds) {
+        if ((int)bird >= BIRD_TYPE_COUNT) return false;
+    }
+    if (level.obstacles.size() > LEVEL_MAX_OBSTACLES) return false;
+
+    for (auto& obs : level.obstacles) obs.visible = true;
+    return true;
+}
+
+// Level select thumbnail, drawn on the CPU so packs can be built headless.
+Image RenderThumbnail(const Level& level) {
+    float scale = THUMBNAIL_WIDTH / WORLD_WIDTH;
+    Image image = GenImageColor(THUMBNAIL_WIDTH, THUMBNAIL_HEIGHT, SKYBLUE);
+    ImageDrawRectangleRec(&image, { 0, GROUND_Y * scale, (float)THUMBNAIL_WIDTH, (WORLD_HEIGHT - GROUND_Y) * scale }, DARKGREEN);
+    for (const auto& obs : level.obstacles) {
+        ImageDrawRectangleRec(&image,
+            { obs.rect.x * scale, obs.rect.y * scale, std::max(1.0f, obs.rect.width * scale), std::max(1.0f, obs.rect.height * scale) },
+            obs.fillColor);
+    }
+    return image;
+}
+
+// Every level the game can play: the built-in levels, or an opened pack.
+class LevelCatalog {
+private:
+    MappedFile pack;
+    uint32_t count = 0;
+    uint32_t indexOffset = 0;
+
+    bool HasPack() const {
+        return pack.Data() != nullptr;
+    }
+
+    ByteReader EntryReader(size_t index) const {
+        return ByteReader(pack.Data() + indexOffset + index * LEVEL_PACK_ENTRY_BYTES, LEVEL_PACK_ENTRY_BYTES);
+    }
+
+    LevelPackEntry Entry(size_t index) const {
+        ByteReader reader = EntryReader(index);
+        return ReadLevelPackEntry(reader);
+    }
+
+public:
+    static constexpr size_t NOT_FOUND = (size_t)-1;
+
+    bool OpenPack(const std::string& path) {
+        pack.Close();
+        count = 0;
+
+        if (!pack.Open(path.c_str())) {
+            fprintf(stderr, "pack: cannot open %s\n", path.c_str());
+            return false;
+        }
+
+        ByteReader header(pack.Data(), pack.Size());
+        bool valid = header.U32() == LEVEL_PACK_MAGIC && header.U16() == LEVEL_PACK_VERSION;
+        header.U16();
+        uint32_t entries = header.U32();
+        uint32_t offset = header.U32();
+        valid = valid && header.Ok() && entries > 0 && offset >= LEVEL_PACK_HEADER_BYTES &&
+            offset + (uint64_t)entries * LEVEL_PACK_ENTRY_BYTES <= pack.Size();
+
+        count = entries;
+        indexOffset = offset;
+        for (size_t i = 0; valid && i < count; ++i) {
+            LevelPackEntry entry = Entry(i);
+            valid = (i == 0 || entry.id > IdAt(i - 1)) && entry.id != 0 &&
+                entry.dataOffset + (uint64_t)entry.dataSize <= offset &&
+                entry.thumbnailOffset + (uint64_t)entry.thumbnailSize <= offset;
+        }
+
+        if (!valid) {
+            fprintf(stderr, "pack: %s is not a valid level pack\n", path.c_str());
+            pack.Close();
+            count = 0;
+            return false;
+        }
+        return true;
+    }
+
+    size_t Count() const {
+        return HasPack() ? count : std::size(BUILTIN_LEVELS);
+    }
+
+    uint32_t IdAt(size_t index) const {
+        if (!HasPack()) return BUILTIN_LEVELS[index].id;
+        ByteReader reader = EntryReader(index);
+        return reader.U32();
+    }
+
+    std::string NameAt(size_t index) const {
+        return HasPack() ? Entry(index).name : BUILTIN_LEVELS[index].name;
+    }
+
+    size_t Find(uint32_t id) const {
+        size_t low = 0, high = Count();
+        while (low < high) {
+            size_t mid = low + (high - low) / 2;
+            if (IdAt(mid) < id) low = mid + 1;
+            else high = mid;
+        }
+        return low < Count() && IdAt(low) == id ? low : NOT_FOUND;
+    }
+
+    bool Load(size_t index, Level& level) const {
+        level.runs.Invalidate();
+        level.id = IdAt(index);
+        level.name = NameAt(index);
+        level.state = LevelState::PLAYING;
+
+        if (!HasPack()) {
+            const BuiltinLevel& builtin = BUILTIN_LEVELS[index];
+            level.targetScore = builtin.targetScore;
+            level.birds = builtin.birds;
+            level.obstacles.assign(builtin.obstacles, builtin.obstacles + builtin.obstacleCount);
+            return true;
+        }
+
+        LevelPackEntry entry = Entry(index);
+        int rawSize = 0;
+        unsigned char* raw = DecompressData(pack.Data() + entry.dataOffset, (int)entry.dataSize, &rawSize);
+        bool loaded = raw != nullptr && (uint32_t)rawSize == entry.rawSize &&
+            LevelChecksum(raw, rawSize) == entry.checksum && DecodeLevel(raw, rawSize, level);
+        if (raw != nullptr) MemFree(raw);
+
+        if (!loaded) {
+            TraceLog(LOG_WARNING, "PACK: level %u is corrupt", entry.id);
+        }
+        return loaded;
+    }
+
+    // Returns an RGBA image of THUMBNAIL_WIDTH x THUMBNAIL_HEIGHT. The caller
+    // unloads it.
+    Image LoadThumbnail(size_t index) const {
+        if (!HasPack()) {
+            Level level;
+            Load(index, level);
+            return RenderThumbnail(level);
+        }
+
+        LevelPackEntry entry = Entry(index);
+        int size = 0;
+        unsigned char* pixels = DecompressData(pack.Data() + entry.thumbnailOffset, (int)entry.thumbnailSize, &size);
+        if (pixels == nullptr || size != THUMBNAIL_WIDTH * THUMBNAIL_HEIGHT * 4) {
+            if (pixels != nullptr) MemFree(pixels);
+            return GenImageColor(THUMBNAIL_WIDTH, THUMBNAIL_HEIGHT, GRAY);
+        }
+
+        Image image = {};
+        image.data = pixels;
+        image.width = THUMBNAIL_WIDTH;
+        image.height = THUMBNAIL_HEIGHT;
+        image.mipmaps = 1;
+        image.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+        return image;
+    }
+};
+
+// The catalog every GameWorld plays from; --pack replaces the built-ins.
+LevelCatalog& ActiveCatalog() {
+    static LevelCatalog catalog;
+    return catalog;
+}
+
+// Destroys every visible block whose centre lies within radius of center.
+int Detonate(Vector2 center, float radius, Level& level) {
+    int destroyed = 0;
+    Rectangle area = { center.x - radius, center.y - radius, radius * 2, radius * 2 };
+    for (uint32_t index : level.runs.Query(level.obstacles, area)) {
+        Obstacle& obs = level.obstacles[index];
+        Vector2 blockCenter = { obs.rect.x + obs.rect.width / 2, obs.rect.y + obs.rect.height / 2 };
+        if (obs.visible && CheckCollisionPointCircle(blockCenter, center, radius)) {
+            level.Destroy(index);
+            destroyed++;
+        }
+    }
+    return destroyed;
+}
+
+// One tick of flight for one bird. Returns the number of blocks destroyed.
+// Hits are reported to impacts with an impulse of speed scaled by size.
+template <class Bird>
+int StepBird(Ball& bird, Level& level, ImpactEvents& impacts) {
+    int destroyed = 0;
+    float mass = bird.radius / NormalBird::RADIUS;
+    auto impulse = [&]() { return std::sqrt(bird.vel.x * bird.vel.x + bird.vel.y * bird.vel.y) * mass; };
+
+    Rectangle reach = { bird.pos.x - bird.radius, bird.pos.y - bird.radius, bird.radius * 2, bird.radius * 2 };
+    for (uint32_t index : level.runs.Query(level.obstacles, reach)) {
+        Obstacle& obs = level.obstacles[index];
+        if (!obs.visible || !bird.filter.Accepts(obs.filter)) continue;
+
+        level.pairTests++;
+        if (bird.CollidesWith(obs)) {
+            destroyed++;
+            level.Destroy(index);
+            impacts.Add(IMPACT_BLOCK, obs.rect.x + obs.rect.width / 2, obs.rect.y + obs.rect.height / 2, impulse());
+
+            if constexpr (Bird::BLAST_RADIUS > 0.0f) {
+                bird.isActive = false;
+                break;
+            }
+            else if constexpr (Bird::IMPACT_SPEED_KEPT > 0.0f) {
+                bird.vel.x *= Bird::IMPACT_SPEED_KEPT;
+            }
+            else {
+                bird.vel.x *= bird.elasticity;
+            }
+        }
+    }
+
+    // The blast queries the grid again, so it goes off after the loop above
+    // is done with the candidates. It is as loud as the hit that set it off.
+    if constexpr (Bird::BLAST_RADIUS > 0.0f) {
+        if (!bird.isActive) {
+            destroyed += Detonate(bird.pos, Bird::BLAST_RADIUS, level);
+            impacts.Add(IMPACT_BLAST, bird.pos.x, bird.pos.y, impulse());
+        }
+    }
+
+    if (destroyed > 0) {
+        level.Update();
+    }
+
+    if constexpr (Bird::BLAST_RADIUS > 0.0f) {
+        if (!bird.isActive) return destroyed;
+    }
+
+    if (bird.filter.Touches(LAYER_GROUND) && bird.pos.y + bird.radius > WORLD_HEIGHT) {
+        impacts.Add(IMPACT_GROUND, bird.pos.x, bird.pos.y + bird.radius, fabs(bird.vel.y) * mass);
+        bird.pos.y = WORLD_HEIGHT - bird.radius;
+        bird.vel.y *= -bird.elasticity;
+    }
+
+    bird.pos.x += bird.vel.x;
+    bird.pos.y += bird.vel.y;
+    bird.vel.y += GRAVITY;
+
+    if constexpr (Bird::RETURN_PULL > 0.0f) {
+        bool returning = bird.vel.y > 0.0f && bird.pos.y < WORLD_HEIGHT - 3 * bird.radius &&
+            bird.vel.x > -Bird::RETURN_SPEED;
+        bird.vel.x -= Bird::RETURN_PULL * returning;
+    }
+
+    bird.rotationAngle += 5;
+    bird.vel.x *= bird.friction;
+    bird.vel.y *= bird.friction;
+
+    if (fabs(bird.vel.x) < 0.1f && fabs(bird.vel.y) < 0.1f &&
+        bird.pos.y > WORLD_HEIGHT - bird.radius - 1) {
+        bird.isActive = false;
+    }
+
+    return destroyed;
+}
+
+template <class Bird>
+int StepBirds(Ball* birds, size_t count, Level& level, ImpactEvents& impacts) {
+    int destroyed = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (birds[i].isActive) {
+            destroyed += StepBird<Bird>(birds[i], level, impacts);
+        }
+    }
+    return destroyed;
+}
+
+typedef int (*BirdStepFunction)(Ball* birds, size_t count, Level& level, ImpactEvents& impacts);
+
+constexpr BirdStepFunction BIRD_STEPS[BIRD_TYPE_COUNT] = {
+    StepBirds<NormalBird>,
+    StepBirds<SplitBird>,
+    StepBirds<HeavyBird>,
+    StepBirds<ExplosiveBird>,
+    StepBirds<BoomerangBird>
+};
+
+// Birds in flight besides the one on the slingshot, grouped by type so each
+// group runs through the step compiled for it.
+class ProjectileSet {
+public:
+    std::array<std::vector<Ball>, BIRD_TYPE_COUNT> groups;
+
+    void Add(const Ball& bird) {
+        groups[(int)bird.type].push_back(bird);
+    }
+
+    void Clear() {
+        for (auto& group : groups) group.clear();
+    }
+
+    size_t Size() const {
+        size_t size = 0;
+        for (const auto& group : groups) size += group.size();
+        return size;
+    }
+
+    bool AnyActive() const {
+        for (const auto& group : groups) {
+            for (const auto& bird : group) {
+                if (bird.isActive) return true;
+            }
+        }
+        return false;
+    }
+
+    int Step(Level& level, ImpactEvents& impacts) {
+        int destroyed = 0;
+        for (int type = 0; type < BIRD_TYPE_COUNT; ++type) {
+            if (!groups[type].empty()) {
+                destroyed += BIRD_STEPS[type](groups[type].data(), groups[type].size(), level, impacts);
+            }
+        }
+        return destroyed;
+    }
+
+    template <class Fn>
+    void ForEach(Fn fn) const {
+        for (const auto& group : groups) {
+            for (const auto& bird : group) fn(bird);
+        }
+    }
+};
+
+template <>
+struct Reflect<ProjectileSet> {
+    using Fields = FieldList<Field<&ProjectileSet::groups>>;
+};
+
+constexpr int SHARDS_MIN = 4;
+constexpr int SHARDS_MAX = 12;
+constexpr int SHARD_POOL_CAPACITY = 512;
+constexpr float SHARD_LIFETIME = 3.0f;
+constexpr float SHARD_FADE_TIME = 0.5f;
+constexpr float SHARD_SLEEP_SPEED = 20.0f;
+constexpr float SHARD_GRAVITY = GRAVITY * TICKS_PER_SECOND * TICKS_PER_SECOND;
+constexpr uint64_t FRACTURE_SEED = 0x2545F491u;
+constexpr float DAMAGE_LAYER_SCALE = 0.5f;
+// Ground hits softer than this leave no cracks.
+constexpr float DAMAGE_CRACK_IMPULSE = 14.0f;
+constexpr uint64_t DAMAGE_SEED = 0xBB67AE85u;
+
+// One piece of a fracture pattern in unit block coordinates (0..1 on both
+// axes): a triangle, or a quad where the piece takes a corner of the block.
+// Vertex 0 is the fracture centre, so the piece is a fan from it.
+struct ShardShape {
+    Vector2 vertices[4];
+    int vertexCount;
+    Vector2 centroid;
+};
+
+struct FracturePattern {
+    std::vector<ShardShape> shards;
+};
+
+// Fracture patterns are baked once per prototype, keyed by size and aspect
+// class, and shared by every block of that kind. A pattern fans triangles
+// from a jittered centre to jittered points around the outline, so the
+// pieces tile the block exactly. All classes are baked up front, so worlds
+// stepped on other threads only ever read the library.
+class FractureLibrary {
+private:
+    static constexpr int SIZE_CLASSES = 5;
+    static constexpr int ASPECT_CLASSES = 5;
+    std::array<FracturePattern, SIZE_CLASSES * ASPECT_CLASSES> patterns;
+
+    static int SizeClass(const Rectangle& rect) {
+        float area = rect.width * rect.height;
+        return std::max(0, std::min(4, (int)std::lround(std::log2(std::max(1.0f, area / 400.0f)))));
+    }
+
+    static int AspectClass(const Rectangle& rect) {
+        float aspect = rect.width / std::max(1.0f, rect.height);
+        return std::max(-2, std::min(2, (int)std::lround(std::log2(std::max(0.01f, aspect)))));
+    }
+
+    static FracturePattern Bake(int sizeClass, int aspectClass) {
+        RandomStream rng(FRACTURE_SEED, RANDOM_FRACTURE, (uint32_t)(sizeClass * 5 + aspectClass + 2));
+        auto next = [&rng]() { return rng.NextFloat(); };
+
+        int count = std::max(SHARDS_MIN, std::min(SHARDS_MAX, SHARDS_MIN + 2 * sizeClass));
+        Vector2 centre = { 0.35f + 0.3f * next(), 0.35f + 0.3f * next() };
+
+        // Points around the outline, walked clockwise from the top-left corner
+        // as a distance along the unit square's perimeter of 4.
+        std::vector<Vector2> outline;
+        for (int i = 0; i < count; ++i) {
+            float along = 4.0f * (i + 0.2f + 0.6f * next()) / count;
+            int side = std::min(3, (int)along);
+            float t = along - side;
+            const Vector2 sides[4] = { { t, 0 }, { 1, t }, { 1 - t, 1 }, { 0, 1 - t } };
+            outline.push_back(sides[side]);
+        }
+
+        FracturePattern pattern;
+        for (int i = 0; i < count; ++i) {
+            Vector2 a = outline[i];
+            Vector2 b = outline[(i + 1) % count];
+            int sideA = a.y == 0 ? 0 : a.x == 1 ? 1 : a.y == 1 ? 2 : 3;
+            int sideB = b.y == 0 ? 0 : b.x == 1 ? 1 : b.y == 1 ? 2 : 3;
+
+            ShardShape shard = { { centre, a, b }, 3, {} };
+            if (sideA != sideB) {
+                const Vector2 corners[4] = { { 1, 0 }, { 1, 1 }, { 0, 1 }, { 0, 0 } };
+                shard = { { centre, a, corners[sideA], b }, 4, {} };
+            }
+
+            Vector2 sum = { 0, 0 };
+            for (int v = 0; v < shard.vertexCount; ++v) {
+                sum.x += shard.vertices[v].x;
+                sum.y += shard.vertices[v].y;
+            }
+            shard.centroid = { sum.x / shard.vertexCount, sum.y / shard.vertexCount };
+
+            // The outline is walked clockwise on screen; raylib wants
+            // counter-clockwise triangles.
+            std::reverse(shard.vertices + 1, shard.vertices + shard.vertexCount);
+            pattern.shards.push_back(shard);
+        }
+        return pattern;
+    }
+
+public:
+    FractureLibrary() {
+        for (int sizeClass = 0; sizeClass < SIZE_CLASSES; ++sizeClass) {
+            for (int aspectClass = -2; aspectClass <= 2; ++aspectClass) {
+                patterns[sizeClass * ASPECT_CLASSES + aspectClass + 2] = Bake(sizeClass, aspectClass);
+            }
+        }
+    }
+
+    const FracturePattern& PatternFor(const Rectangle& rect) const {
+        return patterns[SizeClass(rect) * ASPECT_CLASSES + AspectClass(rect) + 2];
+    }
+};
+
+FractureLibrary& Fractures() {
+    static FractureLibrary library;
+    return library;
+}
+
+struct Shard {
+    Vector2 vertices[4];
+    int vertexCount;
+    Vector2 pos;
+    Vector2 vel;
+    float angle;
+    float spin;
+    float age;
+    Color color;
+    bool asleep;
+};
+
+// Cosmetic debris for destroyed blocks. Bodies live in a fixed pool: a big
+// collapse reuses the oldest pieces instead of allocating, and resting
+// pieces sleep until their lifetime runs out.
+class ShardPool {
+private:
+    std::array<Shard, SHARD_POOL_CAPACITY> shards;
+    std::array<uint16_t, SHARD_POOL_CAPACITY> freeList;
+    std::array<bool, SHARD_POOL_CAPACITY> alive{};
+    int freeCount = 0;
+    std::vector<uint8_t> lastVisible;
+    uint32_t trackedLevel = 0;
+
+    Shard& Acquire() {
+        if (freeCount > 0) {
+            int index = freeList[--freeCount];
+            alive[index] = true;
+            return shards[index];
+        }
+
+        int oldest = 0;
+        for (int i = 1; i < SHARD_POOL_CAPACITY; ++i) {
+            if (shards[i].age > shards[oldest].age) oldest = i;
+        }
+        return shards[oldest];
+    }
+
+    void Release(int index) {
+        alive[index] = false;
+        freeList[freeCount++] = (uint16_t)index;
+    }
+
+    void Break(const Obstacle& obs) {
+        Vector2 centre = { obs.rect.x + obs.rect.width / 2, obs.rect.y + obs.rect.height / 2 };
+        for (const ShardShape& shape : Fractures().PatternFor(obs.rect).shards) {
+            Vector2 local = { shape.centroid.x * obs.rect.width, shape.centroid.y * obs.rect.height };
+            Vector2 outward = { local.x - obs.rect.width / 2, local.y - obs.rect.height / 2 };
+
+            Shard& shard = Acquire();
+            shard.vertexCount = shape.vertexCount;
+            for (int v = 0; v < shape.vertexCount; ++v) {
+                shard.vertices[v] = { shape.vertices[v].x * obs.rect.width - local.x, shape.vertices[v].y * obs.rect.height - local.y };
+            }
+            shard.pos = { obs.rect.x + local.x, obs.rect.y + local.y };
+            shard.vel = { outward.x * 6.0f + 60.0f, outward.y * 6.0f - 120.0f };
+            shard.angle = 0;
+            shard.spin = (shard.pos.x - centre.x) * 12.0f;
+            shard.age = 0;
+            shard.color = obs.fillColor;
+            shard.asleep = false;
+        }
+    }
+
+public:
+    ShardPool() {
+        Clear();
+    }
+
+    void Clear() {
+        freeCount = 0;
+        for (int i = SHARD_POOL_CAPACITY - 1; i >= 0; --i) Release(i);
+        lastVisible.clear();
+        trackedLevel = 0;
+    }
+
+    // Takes the level's current blocks as the baseline without breaking
+    // anything, for when they were edited in place. Live pieces are kept.
+    void Track(const Level& level) {
+        trackedLevel = level.id;
+        lastVisible.resize(level.obstacles.size());
+        for (size_t i = 0; i < level.obstacles.size(); ++i) lastVisible[i] = level.obstacles[i].visible ? 1 : 0;
+    }
+
+    // Breaks every block that disappeared since the last call, then advances
+    // the pieces by dt seconds.
+    void Update(const Level& level, float dt) {
+        if (level.id != trackedLevel || lastVisible.size() != level.obstacles.size()) {
+            Clear();
+            Track(level);
+        }
+
+        for (size_t i = 0; i < level.obstacles.size(); ++i) {
+            uint8_t visible = level.obstacles[i].visible ? 1 : 0;
+            if (lastVisible[i] && !visible) Break(level.obstacles[i]);
+            lastVisible[i] = visible;
+        }
+
+        for (int i = 0; i < SHARD_POOL_CAPACITY; ++i) {
+            if (!alive[i]) continue;
+
+            Shard& shard = shards[i];
+            shard.age += dt;
+            if (shard.age > SHARD_LIFETIME) {
+                Release(i);
+                continue;
+            }
+            if (shard.asleep) continue;
+
+            shard.vel.y += SHARD_GRAVITY * dt;
+            shard.pos.x += shard.vel.x * dt;
+            shard.pos.y += shard.vel.y * dt;
+            shard.angle += shard.spin * dt;
+
+            if (SHARD_FILTER.Touches(LAYER_GROUND) && shard.pos.y > GROUND_Y) {
+                shard.pos.y = GROUND_Y;
+                shard.vel.y *= -0.3f;
+                shard.vel.x *= 0.6f;
+                shard.spin *= 0.5f;
+                if (std::fabs(shard.vel.x) + std::fabs(shard.vel.y) < SHARD_SLEEP_SPEED) shard.asleep = true;
+            }
+        }
+    }
+
+    void Draw() const {
+        for (int i = 0; i < SHARD_POOL_CAPACITY; ++i) {
+            if (!alive[i]) continue;
+
+            const Shard& shard = shards[i];
+            float fade = std::min(1.0f, (SHARD_LIFETIME - shard.age) / SHARD_FADE_TIME);
+            float c = std::cos(toRadians(shard.angle));
+            float s = std::sin(toRadians(shard.angle));
+            Vector2 points[4];
+            for (int v = 0; v < shard.vertexCount; ++v) {
+                points[v] = { shard.pos.x + shard.vertices[v].x * c - shard.vertices[v].y * s,
+                    shard.pos.y + shard.vertices[v].x * s + shard.vertices[v].y * c };
+            }
+            for (int v = 2; v < shard.vertexCount; ++v) {
+                DrawTriangle(points[0], points[v - 1], points[v], Fade(shard.color, fade));
+            }
+            drawSubmissions += shard.vertexCount - 2;
+        }
+    }
+
+    int Active() const {
+        return SHARD_POOL_CAPACITY - freeCount;
+    }
+};
+
+// Scorch marks, cracks and dust left behind by impacts, accumulated in a
+// persistent world-space render target at half resolution. Each impact is
+// stamped into it once, so however much has been destroyed the layer draws
+// as a single quad. Like the debris it is cosmetic and follows the level
+// from frame to frame; when destroyed blocks come back (a restart, a
+// rollback or a seek) it is cleared and the blocks still missing are
+// stamped again.
+class DamageLayer {
+private:
+    struct Mark {
+        ImpactSound kind;
+        Vector2 pos;
+        float size;
+        Color color;
+        uint32_t tick;
+    };
+
+    std::vector<Mark> pending;
+    // Blasts and ground hits on this level in tick order, stamped again
+    // whenever the layer starts over.
+    std::vector<Mark> history;
+    std::vector<uint8_t> lastVisible;
+    uint32_t trackedLevel = 0;
+    uint32_t stampedTick = UINT32_MAX;
+    uint64_t version = 0;
+    bool clear = false;
+
+    void DrawMark(const Mark& mark) {
+        const float s = DAMAGE_LAYER_SCALE;
+        switch (mark.kind) {
+        case IMPACT_BLOCK:
+            DrawEllipse((int)(mark.pos.x * s), (int)(mark.pos.y * s), mark.size * 0.7f * s, 5.0f * s, Fade(mark.color, 0.35f));
+            break;
+        case IMPACT_BLAST:
+            DrawCircleGradient((int)(mark.pos.x * s), (int)(mark.pos.y * s), mark.size * 0.6f * s, { 30, 20, 10, 170 }, { 30, 20, 10, 0 });
+            break;
+        case IMPACT_GROUND: {
+            RandomStream rng(DAMAGE_SEED, RANDOM_DAMAGE, mark.tick);
+            int cracks = 3 + (int)(rng.NextU32() % 3);
+            float reach = std::min(mark.size * 2.0f, 40.0f);
+            for (int i = 0; i < cracks; ++i) {
+                // Each crack runs down into the ground and bends once.
+                Vector2 from = { mark.pos.x * s, mark.pos.y * s };
+                float angle = toRadians(15.0f + 150.0f * rng.NextFloat());
+                for (int segment = 0; segment < 2; ++segment) {
+                    float length = reach * (0.25f + 0.25f * rng.NextFloat()) * s;
+                    Vector2 to = { from.x + std::cos(angle) * length, from.y + std::sin(angle) * length };
+                    DrawLineEx(from, to, 1.0f, { 20, 15, 10, 160 });
+                    from = to;
+                    angle += toRadians(40.0f * (rng.NextFloat() - 0.5f));
+                }
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    void Record(const Mark& mark) {
+        history.push_back(mark);
+        pending.push_back(mark);
+    }
+
+public:
+    // Collects what was destroyed since the last call and the blasts and
+    // hard ground hits of the world's last tick, to be stamped by Stamp().
+    // Blocks coming back (a rollback, a seek or a reset) start the layer
+    // over from the marks made up to this tick; a new level or a level
+    // whose blocks are all back starts it empty.
+    void Update(const Level& level, const ImpactEvents& impacts, uint32_t tick) {
+        while (!history.empty() && history.back().tick > tick) history.pop_back();
+
+        bool newLevel = level.id != trackedLevel;
+        bool restart = newLevel || lastVisible.size() != level.obstacles.size();
+        bool reappeared = false;
+        for (size_t i = 0; i < level.obstacles.size() && !restart; ++i) {
+            reappeared = restart = !lastVisible[i] && level.obstacles[i].visible;
+        }
+        if (restart) {
+            bool intact = std::all_of(level.obstacles.begin(), level.obstacles.end(), [](const Obstacle& obs) { return obs.visible; });
+            if (newLevel || (reappeared && intact)) history.clear();
+            trackedLevel = level.id;
+            lastVisible.assign(level.obstacles.size(), 1);
+            pending = history;
+            clear = true;
+        }
+
+        for (size_t i = 0; i < level.obstacles.size(); ++i) {
+            const Obstacle& obs = level.obstacles[i];
+            if (lastVisible[i] && !obs.visible) {
+                pending.push_back({ IMPACT_BLOCK, { obs.rect.x + obs.rect.width / 2, GROUND_Y }, obs.rect.width, obs.fillColor, tick });
+            }
+            lastVisible[i] = obs.visible ? 1 : 0;
+        }
+
+        if (tick != stampedTick) {
+            stampedTick = tick;
+            const ImpactEvent& blast = impacts[IMPACT_BLAST];
+            if (blast.count > 0) Record({ IMPACT_BLAST, { blast.X(), blast.Y() }, ExplosiveBird::BLAST_RADIUS, BLACK, tick });
+            const ImpactEvent& ground = impacts[IMPACT_GROUND];
+            if (ground.impulse >= DAMAGE_CRACK_IMPULSE) Record({ IMPACT_GROUND, { ground.X(), GROUND_Y }, ground.impulse, BLACK, tick });
+        }
+
+        if (clear || !pending.empty()) version++;
+    }
+
+    // Changes whenever there is something new to stamp.
+    uint64_t Version() const {
+        return version;
+    }
+
+    // Starts over on the next Update, for a target that lost its contents.
+    void Restart() {
+        lastVisible.clear();
+    }
+
+    // Draws what Update collected into the layer's target, which is bound.
+    // Alpha accumulates as coverage instead of being blended like colour,
+    // which leaves the target holding premultiplied colour.
+    void Stamp() {
+        if (clear) ClearBackground(BLANK);
+        rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE, RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD, RL_FUNC_ADD);
+        BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+        for (const Mark& mark : pending) DrawMark(mark);
+        EndBlendMode();
+        pending.clear();
+        clear = false;
+    }
+
+    void Draw(Texture2D layer) const {
+        if (layer.id == 0) return;
+
+        BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+        // Render textures are stored upside down.
+        DrawTexturePro(layer,
+            { 0.0f, 0.0f, (float)layer.width, -(float)layer.height },
+            { 0.0f, 0.0f, WORLD_WIDTH, WORLD_HEIGHT },
+            { 0, 0 },
+            0.0f,
+            WHITE);
+        EndBlendMode();
+        drawSubmissions++;
+    }
+};
+
+// Copy of everything GameWorld::Step reads or writes, used for rollback.
+struct WorldState {
+    Ball ball;
+    ProjectileSet projectiles;
+    uint32_t levelId = 0;
+    std::vector<uint8_t> obstacleVisible;
+    LevelState levelState = LevelState::PLAYING;
+    std::map<uint32_t, int> levelScores;
+    int bankedScore = 0;
+    bool ballSelected = false;
+    bool launched = false;
+    float launchAngle = 0;
+    double relativeAngle = 0;
+    int launchDistance = 0;
+    int xOffset = 0, yOffset = 0;
+    int totalScore = 0;
+    int attempts = BIRDS_PER_LEVEL;
+    bool canUsePowerup = false;
+    bool powerupActive = false;
+    int completionTicks = 0;
+    uint32_t tick = 0;
+};
+
+template <>
+struct Reflect<WorldState> {
+    using Fields = FieldList<Field<&WorldState::ball>, Field<&WorldState::projectiles>, Field<&WorldState::levelId>,
+        Field<&WorldState::obstacleVisible>, Field<&WorldState::levelState, uint8_t>, Field<&WorldState::levelScores>,
+        Field<&WorldState::bankedScore>, Field<&WorldState::ballSelected>, Field<&WorldState::launched>,
+        Field<&WorldState::launchAngle>, Field<&WorldState::relativeAngle>, Field<&WorldState::launchDistance>,
+        Field<&WorldState::xOffset>, Field<&WorldState::yOffset>, Field<&WorldState::totalScore>,
+        Field<&WorldState::attempts>, Field<&WorldState::canUsePowerup>, Field<&WorldState::powerupActive>,
+        Field<&WorldState::completionTicks>, Field<&WorldState::tick>>;
+};
+
+class GameWorld {
+public:
+    Ball ball;
+    ProjectileSet projectiles;
+    const LevelCatalog* catalog = &ActiveCatalog();
+    Level currentLevel;
+    std::map<uint32_t, int> levelScores;
+    int bankedScore = 0;
     Ball* selectedBall = nullptr;
     float xStart = 200, yStart = 0;
     bool launched = false;
@@ -468,413 +2869,3766 @@ public:
     double relativeAngle = 0;
     int launchDistance = 0;
     int xOffset = 0, yOffset = 0;
-    Texture2D staringTexture{}, surprisedTexture{}, launchedTexture{}, splitTexture{};
-    Texture2D levelBackgroundTexture{};
-    Texture2D powerupButtonTexture{};
+    TextureHandle staringTexture, surprisedTexture, launchedTexture, splitTexture;
+    TextureHandle levelBackgroundTexture;
+    TextureHandle powerupButtonTexture;
     bool initialized = false;
-    int currentLevelIndex = 1;
+    bool texturesLoaded = false;
     int totalScore = 0;
-    int attempts = 3;
+    int attempts = BIRDS_PER_LEVEL;
+
+    int powerupCost = 50;
+    bool canUsePowerup = false;
+    bool powerupActive = false;
+    Rectangle powerupButton;
+    int completionTicks = 0;
+    uint32_t tick = 0;
+
+    bool recordShots = false;
+    bool shotInFlight = false;
+    uint32_t shotStartTick = 0;
+    ShotRecord currentShot;
+    std::vector<ShotRecord> finishedShots;
+
+    ImpactEvents impacts;
+    ShardPool shards;
+    DamageLayer damage;
+    Texture2D damageTexture{};
+    // Set when the current level was changed by ApplyLevelEdit since it was
+    // loaded.
+    bool levelEdited = false;
+
+    void Init(bool loadTextures = true) {
+        if (initialized) return;
+
+        if (loadTextures) {
+            staringTexture = Textures().Register("resources/meStaring.png");
+            surprisedTexture = Textures().Register("resources/meSurprised.png");
+            launchedTexture = Textures().Register("resources/meLaunched.png");
+            splitTexture = Textures().Register("resources/meSplit.png");
+            levelBackgroundTexture = Textures().Register("graphics/level_image.png");
+            powerupButtonTexture = Textures().Register("graphics/powerup_button.png");
+            texturesLoaded = true;
+        }
+
+        powerupButton = { WORLD_WIDTH - 150.0f, 60.0f, 100.0f, 40.0f };
+
+        yStart = WORLD_HEIGHT - 200;
+
+        ball.pos = { xStart, yStart };
+        ball.vel = { 50, -50 };
+        ball.radius = NormalBird::RADIUS;
+        ball.friction = 0.99f;
+        ball.elasticity = 0.9f;
+        ball.rotationAngle = 0;
+
+        SetLevel(catalog->IdAt(0));
+
+        initialized = true;
+    }
+
+    // Switches to the level with the given id, loading it from the catalog.
+    // The score of the level being left is banked towards the total.
+    void SetLevel(uint32_t levelId) {
+        size_t index = catalog->Find(levelId);
+        if (index == LevelCatalog::NOT_FOUND) {
+            if (currentLevel.id != 0) return;
+            index = 0;
+        }
+
+        Level next;
+        if (!catalog->Load(index, next)) return;
+
+        Reset();
+
+        if (currentLevel.id != 0) {
+            levelScores[currentLevel.id] = currentLevel.GetCurrentScore();
+        }
+        levelScores.erase(next.id);
+        bankedScore = 0;
+        for (const auto& entry : levelScores) bankedScore += entry.second;
+
+        currentLevel = std::move(next);
+        levelEdited = false;
+        attempts = BIRDS_PER_LEVEL;
+        completionTicks = 0;
+        currentLevel.Reset();
+        LoadNextBird();
+    }
+
+    // True while anything would still change on screen without new input:
+    // a shot in progress, debris, or the countdown to the next level.
+    bool Animating() const {
+        if (selectedBall != nullptr || launched || projectiles.AnyActive() || shards.Active() > 0) return true;
+        return currentLevel.state == LevelState::COMPLETED && NextLevelId() != 0;
+    }
+
+    // Brings the level being played in line with an edited copy of it without
+    // restarting it: only the blocks that changed are touched, and blocks
+    // already destroyed stay destroyed.
+    LevelDiff ApplyLevelEdit(const Level& edited) {
+        LevelDiff diff = DiffObstacles(currentLevel.obstacles, edited.obstacles);
+        ApplyLevelDiff(currentLevel, diff);
+        shards.Track(currentLevel);
+        levelEdited = true;
+
+        currentLevel.name = edited.name;
+        currentLevel.targetScore = edited.targetScore;
+        currentLevel.birds = edited.birds;
+        currentLevel.Update();
+        if (!launched && selectedBall == nullptr) LoadNextBird();
+        return diff;
+    }
+
+    // Id of the level after the current one in the catalog, or 0 at the end.
+    uint32_t NextLevelId() const {
+        size_t index = catalog->Find(currentLevel.id);
+        return index != LevelCatalog::NOT_FOUND && index + 1 < catalog->Count() ? catalog->IdAt(index + 1) : 0;
+    }
+
+    void Destroy() {
+        damageTexture = {};
+        texturesLoaded = false;
+        initialized = false;
+    }
+
+    InputFrame SampleInput(const Camera2D& view) const {
+        InputFrame input;
+
+        if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) input.flags |= INPUT_PRESS;
+        if (IsMouseButtonDown(MOUSE_BUTTON_LEFT)) input.flags |= INPUT_HOLD;
+        if (IsMouseButtonReleased(MOUSE_BUTTON_LEFT)) input.flags |= INPUT_RELEASE;
+        if (IsMouseButtonPressed(MOUSE_BUTTON_RIGHT) || IsKeyPressed(KEY_SPACE)) input.flags |= INPUT_RESET;
+
+        size_t levelKey = catalog->Count();
+        if (IsKeyPressed(KEY_ONE)) levelKey = 0;
+        else if (IsKeyPressed(KEY_TWO)) levelKey = 1;
+        else if (IsKeyPressed(KEY_THREE)) levelKey = 2;
+        else if (IsKeyPressed(KEY_FOUR)) levelKey = 3;
+        if (levelKey < catalog->Count()) input.level = catalog->IdAt(levelKey);
+
+        if (input.flags & (INPUT_PRESS | INPUT_HOLD)) {
+            Vector2 mousePos = GetScreenToWorld2D(GetMousePosition(), view);
+            input.mouseX = static_cast<int16_t>(mousePos.x);
+            input.mouseY = static_cast<int16_t>(mousePos.y);
+        }
+
+        return input;
+    }
+
+    // Advances the simulation by one tick. Reads nothing but the given input
+    // and the world itself, so two worlds fed the same inputs stay identical.
+    void Step(const InputFrame& input) {
+        tick++;
+        impacts.Clear();
+        currentLevel.pairTests = 0;
+
+        if (input.flags & INPUT_SELECT) {
+            SetLevel(input.level);
+            return;
+        }
+
+        if (currentLevel.state == LevelState::COMPLETED) {
+   
+            uint32_t nextLevel = NextLevelId();
+            if (nextLevel != 0) {
+                completionTicks++;
+
+                if (completionTicks > 2 * TICKS_PER_SECOND) {
+                    SetLevel(nextLevel);
+                    completionTicks = 0;
+                }
+            }
+            return;
+        }
+
+        
+        totalScore = bankedScore + currentLevel.GetCurrentScore();
+
+  
+        canUsePowerup = totalScore >= powerupCost;
+
+
+        Vector2 mousePos = { (float)input.mouseX, (float)input.mouseY };
+
+        if (launched && canUsePowerup && !powerupActive && ball.type != BirdType::SPLIT && ball.isActive) {
+            if (input.flags & INPUT_PRESS) {
+  
+                ActivateSplitPowerup();
+            }
+        }
+
+        if (input.flags & INPUT_PRESS) {
+            if (CheckCollisionPointCircle(mousePos, ball.pos, ball.radius) && !launched) {
+                selectedBall = &ball;
+                xOffset = mousePos.x - ball.pos.x;
+                yOffset = mousePos.y - ball.pos.y;
+            }
+        }
+
+        if ((input.flags & INPUT_HOLD) && selectedBall) {
+            ball.pos.x = mousePos.x - xOffset;
+            ball.pos.y = mousePos.y - yOffset;
+
+            int dx = xStart - ball.pos.x;
+            int dy = yStart - ball.pos.y;
+
+            launchDistance = std::sqrt(dx * dx + dy * dy);
+            relativeAngle = atan2(dy, dx) + PI;
+            launchAngle = PI - relativeAngle;
+
+            if (launchDistance > LAUNCH_MAX_DISTANCE) {
+                ball.pos.x = xStart + std::cos(relativeAngle) * LAUNCH_MAX_DISTANCE;
+                ball.pos.y = yStart + std::sin(relativeAngle) * LAUNCH_MAX_DISTANCE;
+            }
+
+            float vx = std::abs(ball.pos.x - xStart) / LAUNCH_MAX_DISTANCE;
+            float vy = -std::abs(ball.pos.y - yStart) / LAUNCH_MAX_DISTANCE;
+
+            ball.vel.x = vx * std::cos(launchAngle) * VELOCITY_MULTIPLIER;
+            ball.vel.y = vy * std::sin(launchAngle) * VELOCITY_MULTIPLIER;
+        }
+
+        if (input.flags & INPUT_RELEASE) {
+            if (selectedBall && (ball.pos.x != xStart || ball.pos.y != yStart)) {
+                launched = true;
+                attempts--;
+                powerupActive = false;
+                BeginShot();
+            }
+            selectedBall = nullptr;
+        }
+
+        if (launched) {
+  
+            if (ball.isActive) {
+                currentShot.blocksDestroyed += BIRD_STEPS[(int)ball.type](&ball, 1, currentLevel, impacts);
+            }
+
+  
+            currentShot.blocksDestroyed += projectiles.Step(currentLevel, impacts);
+
+ 
+            if (currentLevel.state == LevelState::COMPLETED) {
+                FinishShot();
+            }
+
+            bool allBallsStopped = !ball.isActive && !projectiles.AnyActive();
+
+            if (allBallsStopped) {
+          
+                if (attempts <= 0) {
+               
+                    if (currentLevel.state != LevelState::COMPLETED) {
+                        currentLevel.state = LevelState::FAILED;
+                    }
+                }
+
+                FinishShot();
+                ResetBalls();
+            }
+        }
+
+        if (input.flags & INPUT_RESET) {
+            Reset();
+            currentLevel.Reset();
+            attempts = BIRDS_PER_LEVEL;
+            LoadNextBird();
+        }
+
+
+        if (input.level != 0) {
+            SetLevel(input.level);
+        }
+    }
+
+    void SaveState(WorldState& state) {
+        state.ball = ball;
+        state.projectiles = projectiles;
+        state.levelId = currentLevel.id;
+        state.obstacleVisible.clear();
+        for (const auto& obs : currentLevel.obstacles) {
+            state.obstacleVisible.push_back(obs.visible ? 1 : 0);
+        }
+        state.levelState = currentLevel.state;
+        state.levelScores = levelScores;
+        state.bankedScore = bankedScore;
+        state.ballSelected = selectedBall != nullptr;
+        state.launched = launched;
+        state.launchAngle = launchAngle;
+        state.relativeAngle = relativeAngle;
+        state.launchDistance = launchDistance;
+        state.xOffset = xOffset;
+        state.yOffset = yOffset;
+        state.totalScore = totalScore;
+        state.attempts = attempts;
+        state.canUsePowerup = canUsePowerup;
+        state.powerupActive = powerupActive;
+        state.completionTicks = completionTicks;
+        state.tick = tick;
+    }
+
+    void LoadState(const WorldState& state) {
+        ball = state.ball;
+        projectiles = state.projectiles;
+        if (currentLevel.id != state.levelId) {
+            catalog->Load(catalog->Find(state.levelId), currentLevel);
+        }
+        // A keyframe read from a replay file can disagree with the level;
+        // the seeker's hash check rejects it after loading.
+        size_t visibleCount = std::min(currentLevel.obstacles.size(), state.obstacleVisible.size());
+        for (size_t i = 0; i < visibleCount; ++i) {
+            currentLevel.obstacles[i].visible = state.obstacleVisible[i] != 0;
+        }
+        currentLevel.runs.Invalidate();
+        currentLevel.state = state.levelState;
+        levelScores = state.levelScores;
+        bankedScore = state.bankedScore;
+        selectedBall = state.ballSelected ? &ball : nullptr;
+        launched = state.launched;
+        launchAngle = state.launchAngle;
+        relativeAngle = state.relativeAngle;
+        launchDistance = state.launchDistance;
+        xOffset = state.xOffset;
+        yOffset = state.yOffset;
+        totalScore = state.totalScore;
+        attempts = state.attempts;
+        canUsePowerup = state.canUsePowerup;
+        powerupActive = state.powerupActive;
+        completionTicks = state.completionTicks;
+        tick = state.tick;
+    }
+
+    uint64_t StateHash() {
+        uint64_t hash = HASH_SEED;
+        hash = HashValue(hash, tick);
+        hash = HashValue(hash, currentLevel.id);
+        hash = HashValue(hash, attempts);
+        hash = HashValue(hash, totalScore);
+        hash = HashValue(hash, completionTicks);
+        hash = HashValue(hash, (uint8_t)launched);
+        hash = HashValue(hash, (uint8_t)powerupActive);
+        hash = HashValue(hash, (uint8_t)(selectedBall != nullptr));
+        hash = HashBall(hash, ball);
+        projectiles.ForEach([&](const Ball& bird) {
+            hash = HashBall(hash, bird);
+        });
+        hash = HashValue(hash, currentLevel.state);
+        for (const auto& obs : currentLevel.obstacles) {
+            hash = HashValue(hash, (uint8_t)obs.visible);
+        }
+        for (const auto& entry : levelScores) {
+            hash = HashValue(hash, entry.first);
+            hash = HashValue(hash, entry.second);
+        }
+        return hash;
+    }
+
+    static uint64_t HashBall(uint64_t hash, const Ball& b) {
+        hash = HashValue(hash, b.pos);
+        hash = HashValue(hash, b.vel);
+        hash = HashValue(hash, b.radius);
+        hash = HashValue(hash, b.rotationAngle);
+        hash = HashValue(hash, (uint8_t)b.type);
+        return HashValue(hash, (uint8_t)b.isActive);
+    }
+
+    void ActivateSplitPowerup() {
+        if (!canUsePowerup || !launched || ball.type == BirdType::SPLIT || projectiles.Size() > 0) return;
+
+     
+        totalScore -= powerupCost;
+        powerupActive = true;
+
+      
+        projectiles.Add(ball.CreateSplitBall(-30.0f));
+        projectiles.Add(ball.CreateSplitBall(30.0f));
+
+       
+        ball.type = BirdType::SPLIT;
+        ball.radius = SplitBird::RADIUS;
+        currentShot.splitTick = (int32_t)(tick - shotStartTick);
+    }
+
+    void BeginShot() {
+        shotInFlight = recordShots;
+        shotStartTick = tick;
+        currentShot = ShotRecord();
+        currentShot.level = currentLevel.id;
+        currentShot.dragX = ball.pos.x - xStart;
+        currentShot.dragY = ball.pos.y - yStart;
+    }
+
+    void FinishShot() {
+        if (!shotInFlight) return;
+
+        currentShot.finalScore = currentLevel.GetCurrentScore();
+        currentShot.completed = currentLevel.state == LevelState::COMPLETED ? 1 : 0;
+        currentShot.flightTicks = (int32_t)(tick - shotStartTick);
+        finishedShots.push_back(currentShot);
+        shotInFlight = false;
+    }
+
+    void Reset() {
+        ResetBalls();
+        powerupActive = false;
+    }
+
+    void ResetBalls() {
+        ball.pos = { xStart, yStart };
+        ball.vel = { 50, -50 };
+        ball.rotationAngle = 0;
+        ball.isActive = true;
+        launched = false;
+        selectedBall = nullptr;
+        projectiles.Clear();
+        shotInFlight = false;
+        LoadNextBird();
+    }
+
+    Texture2D BirdFace(const Ball& bird, bool selected) {
+        if (selected) return Textures().Get(surprisedTexture);
+        if (!launched) return Textures().Get(staringTexture);
+
+        if (bird.type == BirdType::SPLIT) {
+            Texture2D split = Textures().Get(splitTexture);
+            if (split.id > 0) return split;
+        }
+        return Textures().Get(launchedTexture);
+    }
+
+    // Puts the level's next bird from its lineup on the slingshot.
+    void LoadNextBird() {
+        int shot = std::max(0, std::min(BIRDS_PER_LEVEL - 1, BIRDS_PER_LEVEL - attempts));
+        ball.type = currentLevel.birds[shot];
+        ball.radius = BIRD_TRAITS[(int)ball.type].radius;
+    }
+
+    // Declares the offscreen passes Draw() reads this frame and returns the
+    // target the screen pass drawing the world has to read. The damage layer
+    // is kept under the given name, which each world in a graph needs its
+    // own of.
+    FrameResource AddPasses(FrameGraph& graph, const char* damageName) {
+        FrameResource layer = graph.Persistent(damageName, (int)(WORLD_WIDTH * DAMAGE_LAYER_SCALE), (int)(WORLD_HEIGHT * DAMAGE_LAYER_SCALE));
+        if (graph.Fresh(layer)) damage.Restart();
+        damage.Update(currentLevel, impacts, tick);
+        graph.AddPass(damageName, layer, {}, damage.Version(), [this]() { damage.Stamp(); });
+        damageTexture = graph.Target(layer).texture;
+        return layer;
+    }
+
+    void Draw() {
+        Texture2D background = Textures().Get(levelBackgroundTexture);
+        drawSubmissions++;
+        if (background.id > 0) {
+            DrawTexturePro(background,
+                { 0.0f, 0.0f, (float)background.width, (float)background.height },
+                { 0.0f, 0.0f, WORLD_WIDTH, WORLD_HEIGHT },
+                { 0, 0 },
+                0.0f,
+                WHITE);
+        }
+        else {
+            DrawRectangle(0, 0, (int)WORLD_WIDTH, (int)WORLD_HEIGHT, DARKGRAY);
+            DrawText("Failed to load background texture!", 10, (int)WORLD_HEIGHT / 2, 20, RED);
+        }
+
+        // Marks sit on the backdrop, under everything else.
+        damage.Draw(damageTexture);
+
+       
+        DrawRectangle(xStart - 10, yStart - ball.radius - 10, 20, ball.radius * 2 + 130, { 100, 100, 100, 200 });
+
+       
+        currentLevel.runs.Draw(currentLevel.obstacles);
+
+        // Debris is cosmetic and advances with the frame, not the simulation.
+        shards.Update(currentLevel, GetFrameTime());
+        shards.Draw();
+
+        
+        projectiles.ForEach([&](const Ball& bird) {
+            if (bird.isActive) {
+                bird.Draw(BirdFace(bird, false), launched, xStart, yStart);
+            }
+        });
+
+      
+        if (ball.isActive) {
+            ball.Draw(BirdFace(ball, selectedBall != nullptr), launched, xStart, yStart);
+        }
+
+       
+        DrawRectangle(0, 0, (int)WORLD_WIDTH, 50, { 0, 0, 0, 120 });
+
+        
+        DrawText(TextFormat("Level %u: %s", currentLevel.id, currentLevel.name.c_str()), 10, 10, 20, WHITE);
+        DrawText(TextFormat("Score: %d/%d", currentLevel.GetCurrentScore(), currentLevel.targetScore), 400, 10, 20, WHITE);
+        DrawText(TextFormat("Total Score: %d", totalScore), 600, 10, 20, WHITE);
+        DrawText(TextFormat("Attempts: %d", attempts), 800, 10, 20, WHITE);
+        DrawText(TextFormat("Bird: %s", BIRD_TRAITS[(int)ball.type].name), 960, 10, 20, WHITE);
+
+        Texture2D powerupTexture = Textures().Get(powerupButtonTexture);
+        if (powerupTexture.id > 0) {
+            DrawTexturePro(powerupTexture,
+                { 0.0f, 0.0f, (float)powerupTexture.width, (float)powerupTexture.height },
+                powerupButton,
+                { 0, 0 },
+                0.0f,
+                canUsePowerup && launched && !powerupActive && ball.type != BirdType::SPLIT ? WHITE : GRAY);
+        }
+        else {
+            DrawRectangleRec(powerupButton, canUsePowerup && launched && !powerupActive && ball.type != BirdType::SPLIT ? BLUE : DARKGRAY);
+            DrawRectangleLinesEx(powerupButton, 2, BLACK);
+            DrawText("SPLIT", powerupButton.x + 10, powerupButton.y + 10, 20, WHITE);
+        }
+        DrawText(TextFormat("Cost: %d", powerupCost), powerupButton.x, powerupButton.y + powerupButton.height + 5, 16, WHITE);
+
+     
+        if (currentLevel.state == LevelState::COMPLETED) {
+            const char* message = "LEVEL COMPLETED!";
+            int fontSize = 40;
+            int textWidth = MeasureText(message, fontSize);
+            DrawRectangle(((int)WORLD_WIDTH - textWidth) / 2 - 10, (int)WORLD_HEIGHT / 2 - 30, textWidth + 20, 60, { 0, 0, 0, 200 });
+            DrawText(message, ((int)WORLD_WIDTH - textWidth) / 2, (int)WORLD_HEIGHT / 2 - 20, fontSize, GREEN);
+
+            if (NextLevelId() != 0) {
+                const char* nextMessage = "Next level loading...";
+                int nextFontSize = 20;
+                int nextTextWidth = MeasureText(nextMessage, nextFontSize);
+                DrawText(nextMessage, ((int)WORLD_WIDTH - nextTextWidth) / 2, (int)WORLD_HEIGHT / 2 + 30, nextFontSize, WHITE);
+            }
+            else {
+                const char* finalMessage = "Congratulations! You completed all levels!";
+                int finalFontSize = 20;
+                int finalTextWidth = MeasureText(finalMessage, finalFontSize);
+                DrawText(finalMessage, ((int)WORLD_WIDTH - finalTextWidth) / 2, (int)WORLD_HEIGHT / 2 + 30, finalFontSize, WHITE);
+            }
+        }
+        else if (currentLevel.state == LevelState::FAILED && attempts <= 0) {
+            const char* message = "NO ATTEMPTS LEFT!";
+            int fontSize = 40;
+            int textWidth = MeasureText(message, fontSize);
+            DrawRectangle(((int)WORLD_WIDTH - textWidth) / 2 - 10, (int)WORLD_HEIGHT / 2 - 30, textWidth + 20, 60, { 0, 0, 0, 200 });
+            DrawText(message, ((int)WORLD_WIDTH - textWidth) / 2, (int)WORLD_HEIGHT / 2 - 20, fontSize, RED);
+
+            const char* retryMessage = "Press SPACE to retry";
+            int retryFontSize = 20;
+            int retryTextWidth = MeasureText(retryMessage, retryFontSize);
+            DrawText(retryMessage, ((int)WORLD_WIDTH - retryTextWidth) / 2, (int)WORLD_HEIGHT / 2 + 30, retryFontSize, WHITE);
+        }
+
+        
+        DrawText("Controls: 1,2,3,4 - Select Level | SPACE - Reset | ESC - Menu", 10, (int)WORLD_HEIGHT - 30, 20, WHITE);
+        DrawText("Left click during flight to activate power-up!", 10, (int)WORLD_HEIGHT - 60, 20, YELLOW);
+    }
+};
+
+// Marks a run whose frames carry a level id, stored after the mouse.
+constexpr uint8_t INPUT_RUN_LEVEL = 1 << 5;
+
+void WriteInputRun(ByteWriter& writer, const InputFrame& frame, int length) {
+    writer.U8((uint8_t)length);
+    writer.U8((uint8_t)(frame.flags | (frame.level != 0 ? INPUT_RUN_LEVEL : 0)));
+    if (frame.flags & (INPUT_PRESS | INPUT_HOLD)) {
+        writer.I16(frame.mouseX);
+        writer.I16(frame.mouseY);
+    }
+    if (frame.level != 0) writer.VarU32(frame.level);
+}
+
+int ReadInputRun(ByteReader& reader, InputFrame& frame) {
+    int length = reader.U8();
+    uint8_t packed = reader.U8();
+
+    frame = InputFrame();
+    frame.flags = packed & 0x1F;
+    if (frame.flags & (INPUT_PRESS | INPUT_HOLD)) {
+        frame.mouseX = reader.I16();
+        frame.mouseY = reader.I16();
+    }
+    if (packed & INPUT_RUN_LEVEL) frame.level = reader.VarU32();
+    return length;
+}
+
+// Two-player versus: each peer runs its own GameWorld plus a mirror of the
+// opponent's, and only input frames cross the wire. Local input is scheduled
+// LOCKSTEP_INPUT_DELAY ticks ahead; the mirror runs on predicted input and
+// rolls back to a snapshot when the real input disagrees.
+constexpr int LOCKSTEP_INPUT_DELAY = 4;
+constexpr int LOCKSTEP_MAX_ROLLBACK = 30;
+constexpr int LOCKSTEP_SEND_INTERVAL = 4;
+constexpr int LOCKSTEP_HASH_INTERVAL = 30;
+constexpr int LOCKSTEP_HISTORY = 128;
+constexpr uint16_t LOCKSTEP_MAGIC = 0xAB01;
+
+void WriteInputRuns(ByteWriter& writer, const InputFrame* frames, int count) {
+    size_t runCountOffset = writer.bytes.size();
+    writer.U8(0);
+
+    int runs = 0;
+    int i = 0;
+    while (i < count) {
+        int length = 1;
+        while (i + length < count && length < 255 && frames[i + length] == frames[i]) {
+            length++;
+        }
+
+        WriteInputRun(writer, frames[i], length);
+        runs++;
+        i += length;
+    }
+
+    writer.bytes[runCountOffset] = (uint8_t)runs;
+}
+
+bool ReadInputRuns(ByteReader& reader, std::vector<InputFrame>& frames) {
+    int runs = reader.U8();
+    for (int r = 0; r < runs && reader.Ok(); ++r) {
+        InputFrame frame;
+        int length = ReadInputRun(reader, frame);
+        frames.insert(frames.end(), length, frame);
+    }
+    return reader.Ok();
+}
+
+class LockstepSession {
+private:
+    UdpSocket socket;
+    NetAddress peer;
+
+    std::array<InputFrame, LOCKSTEP_HISTORY> localInputs{};
+    std::array<InputFrame, LOCKSTEP_HISTORY> remoteInputs{};
+    std::array<InputFrame, LOCKSTEP_HISTORY> remoteUsed{};
+    std::array<WorldState, LOCKSTEP_HISTORY> remoteSnapshots;
+    InputFrame pendingInput;
+
+    uint32_t remoteReceived = 0;
+    uint32_t peerAck = 0;
+    int framesSinceSend = 0;
+
+    uint32_t localHashTick = 0;
+    uint64_t localHash = 0;
+    int localHashResends = 0;
+    std::map<uint32_t, uint64_t> peerHashes;
+    std::map<uint32_t, uint64_t> remoteHashes;
+
+    size_t bytesSent = 0;
+    double statsStartTime = 0;
+
+public:
+    GameWorld localWorld;
+    GameWorld remoteWorld;
+    uint32_t tick = 0;
+    bool peerSeen = false;
+    bool peerUnreachable = false;
+    bool stalled = false;
+    bool desynced = false;
+    uint32_t desyncTick = 0;
+    int rollbacks = 0;
+
+    bool Start(uint16_t localPort, const char* remoteHost, uint16_t remotePort, uint32_t level) {
+        if (!NetStartup()) return false;
+        if (!ResolveAddress(remoteHost, remotePort, peer)) return false;
+        if (!socket.Open(localPort)) return false;
+
+        localWorld.Init();
+        remoteWorld.Init(false);
+        localWorld.SetLevel(level);
+        remoteWorld.SetLevel(level);
+
+        statsStartTime = GetTime();
+        return true;
+    }
+
+    void Shutdown() {
+        localWorld.Destroy();
+        remoteWorld.Destroy();
+        socket.Close();
+        NetShutdown();
+    }
+
+    void Update() {
+        InputFrame sampled = localWorld.SampleInput(WorldCamera());
+        pendingInput.flags |= sampled.flags;
+        if (sampled.level != 0) pendingInput.level = sampled.level;
+        if (sampled.flags & (INPUT_PRESS | INPUT_HOLD)) {
+            pendingInput.mouseX = sampled.mouseX;
+            pendingInput.mouseY = sampled.mouseY;
+        }
+        if (!(pendingInput.flags & (INPUT_PRESS | INPUT_HOLD))) {
+            pendingInput.mouseX = 0;
+            pendingInput.mouseY = 0;
+        }
+
+        ReceivePackets();
+
+        stalled = tick >= remoteReceived + LOCKSTEP_MAX_ROLLBACK ||
+            tick + LOCKSTEP_INPUT_DELAY + 1 >= peerAck + LOCKSTEP_HISTORY;
+
+        bool urgent = false;
+        if (!stalled) {
+            localInputs[(tick + LOCKSTEP_INPUT_DELAY) % LOCKSTEP_HISTORY] = pendingInput;
+            urgent = (pendingInput.flags & (INPUT_PRESS | INPUT_RELEASE | INPUT_RESET)) || pendingInput.level != 0;
+            pendingInput = InputFrame();
+
+            localWorld.Step(localInputs[tick % LOCKSTEP_HISTORY]);
+            StepRemote(tick);
+
+            if (tick % LOCKSTEP_HASH_INTERVAL == 0) {
+                localHashTick = tick;
+                localHash = localWorld.StateHash();
+                localHashResends = 3;
+            }
+            tick++;
+        }
+
+        if (urgent || ++framesSinceSend >= LOCKSTEP_SEND_INTERVAL) {
+            SendPacket();
+            framesSinceSend = 0;
+        }
+    }
+
+    float BytesPerSecond() const {
+        double elapsed = GetTime() - statsStartTime;
+        return elapsed > 0 ? (float)(bytesSent / elapsed) : 0.0f;
+    }
+
+    void Draw() {
+        localWorld.Draw();
+
+        Rectangle panel = { WORLD_WIDTH - 320.0f, 130.0f, 300.0f, 110.0f };
+        DrawRectangleRec(panel, { 0, 0, 0, 150 });
+        DrawText("Opponent", panel.x + 10, panel.y + 8, 20, WHITE);
+        DrawText(TextFormat("Level %u  Score %d/%d", remoteWorld.currentLevel.id,
+            remoteWorld.currentLevel.GetCurrentScore(), remoteWorld.currentLevel.targetScore),
+            panel.x + 10, panel.y + 34, 18, WHITE);
+        DrawText(TextFormat("Attempts: %d", remoteWorld.attempts), panel.x + 10, panel.y + 56, 18, WHITE);
+        DrawText(TextFormat("Tick %u  Net %.0f B/s  Rollbacks %d", tick, BytesPerSecond(), rollbacks),
+            panel.x + 10, panel.y + 80, 16, LIGHTGRAY);
+
+        if (desynced) {
+            DrawText(TextFormat("DESYNC at tick %u", desyncTick), panel.x + 10, panel.y + panel.height + 8, 20, RED);
+        }
+        else if (peerUnreachable) {
+            DrawText("Opponent unreachable", panel.x + 10, panel.y + panel.height + 8, 20, RED);
+        }
+        else if (!peerSeen) {
+            DrawText("Waiting for opponent...", panel.x + 10, panel.y + panel.height + 8, 20, YELLOW);
+        }
+        else if (stalled) {
+            DrawText("Waiting for opponent input...", panel.x + 10, panel.y + panel.height + 8, 20, YELLOW);
+        }
+    }
+
+private:
+    InputFrame PredictRemote() const {
+        if (remoteReceived == 0) return InputFrame();
+
+        InputFrame predicted = remoteInputs[(remoteReceived - 1) % LOCKSTEP_HISTORY];
+        predicted.flags &= INPUT_HOLD;
+        predicted.level = 0;
+        if (!(predicted.flags & INPUT_HOLD)) {
+            predicted.mouseX = 0;
+            predicted.mouseY = 0;
+        }
+        return predicted;
+    }
+
+    void StepRemote(uint32_t t) {
+        remoteWorld.SaveState(remoteSnapshots[t % LOCKSTEP_HISTORY]);
+
+        InputFrame input = t < remoteReceived ? remoteInputs[t % LOCKSTEP_HISTORY] : PredictRemote();
+        remoteUsed[t % LOCKSTEP_HISTORY] = input;
+        remoteWorld.Step(input);
+
+        if (t % LOCKSTEP_HASH_INTERVAL == 0) {
+            remoteHashes[t] = remoteWorld.StateHash();
+        }
+    }
+
+    void ReceivePackets() {
+        uint8_t buffer[1500];
+        NetAddress from;
+        uint32_t rollbackFrom = tick;
+
+        int received;
+        while ((received = socket.ReceiveFrom(from, buffer, sizeof(buffer))) > 0) {
+            if (!(from == peer)) continue;
+
+            ByteReader reader(buffer, (size_t)received);
+            if (reader.U16() != LOCKSTEP_MAGIC) continue;
+
+            uint32_t ack = reader.U32();
+            uint32_t firstTick = reader.U32();
+            std::vector<InputFrame> frames;
+            if (!ReadInputRuns(reader, frames)) continue;
+
+            bool hasHash = reader.U8() != 0;
+            uint32_t hashTick = hasHash ? reader.U32() : 0;
+            uint64_t hash = hasHash ? reader.U64() : 0;
+            if (!reader.Ok() || firstTick > remoteReceived) continue;
+
+            peerSeen = true;
+            peerUnreachable = false;
+            if (ack > peerAck) peerAck = ack;
+            if (hasHash) peerHashes[hashTick] = hash;
+
+            for (size_t i = 0; i < frames.size(); ++i) {
+                uint32_t t = firstTick + (uint32_t)i;
+                if (t < remoteReceived) continue;
+
+                remoteInputs[t % LOCKSTEP_HISTORY] = frames[i];
+                if (t < tick && remoteUsed[t % LOCKSTEP_HISTORY] != frames[i] && t < rollbackFrom) {
+                    rollbackFrom = t;
+                }
+                remoteReceived = t + 1;
+            }
+        }
+        if (received < 0) {
+            peerUnreachable = true;
+        }
+
+        if (rollbackFrom < tick) {
+            rollbacks++;
+            remoteWorld.LoadState(remoteSnapshots[rollbackFrom % LOCKSTEP_HISTORY]);
+            for (uint32_t t = rollbackFrom; t < tick; ++t) {
+                StepRemote(t);
+            }
+        }
+
+        CheckDesync();
+    }
+
+    void CheckDesync() {
+        for (auto it = peerHashes.begin(); it != peerHashes.end();) {
+            uint32_t hashTick = it->first;
+            auto mirror = remoteHashes.find(hashTick);
+            if (hashTick + LOCKSTEP_HISTORY < tick) {
+                it = peerHashes.erase(it);
+                continue;
+            }
+            if (hashTick >= remoteReceived || mirror == remoteHashes.end()) {
+                ++it;
+                continue;
+            }
+
+            if (mirror->second != it->second && !desynced) {
+                desynced = true;
+                desyncTick = hashTick;
+                TraceLog(LOG_WARNING, "VERSUS: state hash mismatch at tick %u", hashTick);
+            }
+            it = peerHashes.erase(it);
+        }
+
+        while (!remoteHashes.empty() && remoteHashes.begin()->first + LOCKSTEP_HISTORY < tick) {
+            remoteHashes.erase(remoteHashes.begin());
+        }
+    }
+
+    void SendPacket() {
+        uint32_t scheduledEnd = tick + LOCKSTEP_INPUT_DELAY;
+        uint32_t first = peerAck < scheduledEnd ? peerAck : scheduledEnd;
+
+        InputFrame frames[LOCKSTEP_HISTORY];
+        int count = 0;
+        for (uint32_t t = first; t < scheduledEnd; ++t) {
+            frames[count++] = localInputs[t % LOCKSTEP_HISTORY];
+        }
+
+        ByteWriter writer;
+        writer.U16(LOCKSTEP_MAGIC);
+        writer.U32(remoteReceived);
+        writer.U32(first);
+        WriteInputRuns(writer, frames, count);
+
+        if (localHashResends > 0) {
+            writer.U8(1);
+            writer.U32(localHashTick);
+            writer.U64(localHash);
+            localHashResends--;
+        }
+        else {
+            writer.U8(0);
+        }
+
+        if (socket.SendTo(peer, writer.bytes.data(), writer.bytes.size())) {
+            bytesSent += writer.bytes.size();
+        }
+    }
+};
+
+int RunVersus(uint16_t localPort, const char* remoteHost, uint16_t remotePort, uint32_t level) {
+    LockstepSession session;
+    if (!session.Start(localPort, remoteHost, remotePort, level)) {
+        TraceLog(LOG_ERROR, "VERSUS: could not open port %d towards %s:%d", localPort, remoteHost, remotePort);
+        return 1;
+    }
+
+    FrameGraph graph;
+    while (!WindowShouldClose() && !IsKeyPressed(KEY_ESCAPE)) {
+        session.Update();
+
+        FrameResource damage = session.localWorld.AddPasses(graph, "Local damage");
+        graph.AddPass("Screen", FRAME_BACKBUFFER, { damage }, 0, [&]() {
+            ClearBackground(BLACK);
+            BeginMode2D(WorldCamera());
+            session.Draw();
+            EndMode2D();
+        });
+        graph.Execute();
+    }
+
+    TraceLog(LOG_INFO, "VERSUS: %u ticks, %.0f B/s sent, %d rollbacks%s", session.tick,
+        session.BytesPerSecond(), session.rollbacks, session.desynced ? ", DESYNCED" : "");
+    session.Shutdown();
+    return 0;
+}
+
+// World state keyframes for seeking in long replays. A keyframe holds the
+// WorldState at the start of a replay tick, compressed, and the state hash
+// it had, so a keyframe that does not load back to the same world (a
+// corrupt file, or a level that changed since) is detected and skipped.
+constexpr uint32_t REPLAY_KEYFRAME_INTERVAL = 5 * TICKS_PER_SECOND;
+constexpr uint32_t REPLAY_MIN_KEYFRAME_INTERVAL = TICKS_PER_SECOND;
+constexpr size_t REPLAY_KEYFRAME_ENTRY_BYTES = 24;
+
+void WriteWorldState(ByteWriter& writer, const WorldState& state) {
+    Serialize(writer, state);
+}
+
+bool ReadWorldState(ByteReader& reader, WorldState& state) {
+    if (!Deserialize(reader, state) || reader.Remaining() != 0) return false;
+    if ((int)state.ball.type >= BIRD_TYPE_COUNT) return false;
+    bool valid = true;
+    state.projectiles.ForEach([&](const Ball& bird) {
+        if ((int)bird.type >= BIRD_TYPE_COUNT) valid = false;
+    });
+    return valid;
+}
+
+struct ReplayKeyframe {
+    uint32_t tick = 0;
+    uint64_t hash = 0;
+    uint32_t rawSize = 0;
+    std::vector<uint8_t> compressed;
+};
+
+struct ReplayKeyframes {
+    uint32_t interval = REPLAY_KEYFRAME_INTERVAL;
+    std::vector<ReplayKeyframe> frames;
+
+    // Called with the world as it is before input number `tick` is stepped;
+    // keeps a keyframe every interval ticks.
+    void Capture(GameWorld& world, uint32_t tick) {
+        if (tick == 0 || tick % interval != 0) return;
+
+        WorldState state;
+        world.SaveState(state);
+        ByteWriter writer;
+        WriteWorldState(writer, state);
+
+        ReplayKeyframe frame;
+        frame.tick = tick;
+        frame.hash = world.StateHash();
+        frame.rawSize = (uint32_t)writer.bytes.size();
+        int length = 0;
+        unsigned char* compressed = CompressData(writer.bytes.data(), (int)writer.bytes.size(), &length);
+        if (compressed == nullptr) return;
+        frame.compressed.assign(compressed, compressed + length);
+        MemFree(compressed);
+        frames.push_back(std::move(frame));
+    }
+
+    // Index of the last keyframe at or before tick, or -1.
+    int Before(uint32_t tick) const {
+        auto after = std::upper_bound(frames.begin(), frames.end(), tick,
+            [](uint32_t t, const ReplayKeyframe& frame) { return t < frame.tick; });
+        return (int)(after - frames.begin()) - 1;
+    }
+};
+
+// A replay is every input frame fed to a freshly initialized GameWorld,
+// including the level choices made on the level select screen. Version 4
+// appends the keyframes: an index of (tick, hash, offset, sizes) entries
+// followed by the compressed states, so a reader can load just one.
+constexpr uint32_t REPLAY_MAGIC = 0x50524241;
+constexpr uint16_t REPLAY_VERSION = 4;
+constexpr uint16_t REPLAY_VERSION_WITHOUT_KEYFRAMES = 3;
+constexpr uint32_t REPLAY_MAX_TICKS = 60 * 60 * TICKS_PER_SECOND;
+
+std::vector<uint8_t> EncodeReplay(const std::vector<InputFrame>& inputs, const ReplayKeyframes& keyframes) {
+    ByteWriter writer;
+    writer.U32(REPLAY_MAGIC);
+    writer.U16(REPLAY_VERSION);
+    writer.U16(0);
+    writer.U32((uint32_t)inputs.size());
+
+    size_t runCountOffset = writer.bytes.size();
+    writer.U32(0);
+
+    uint32_t runs = 0;
+    size_t i = 0;
+    while (i < inputs.size()) {
+        int length = 1;
+        while (i + length < inputs.size() && length < 255 && inputs[i + length] == inputs[i]) {
+            length++;
+        }
+        WriteInputRun(writer, inputs[i], length);
+        runs++;
+        i += length;
+    }
+
+    for (int b = 0; b < 4; ++b) {
+        writer.bytes[runCountOffset + b] = (uint8_t)(runs >> (8 * b));
+    }
+
+    writer.U32(keyframes.interval);
+    writer.U32((uint32_t)keyframes.frames.size());
+    uint32_t offset = 0;
+    for (const ReplayKeyframe& frame : keyframes.frames) {
+        writer.U32(frame.tick);
+        writer.U64(frame.hash);
+        writer.U32(offset);
+        writer.U32((uint32_t)frame.compressed.size());
+        writer.U32(frame.rawSize);
+        offset += (uint32_t)frame.compressed.size();
+    }
+    for (const ReplayKeyframe& frame : keyframes.frames) {
+        writer.bytes.insert(writer.bytes.end(), frame.compressed.begin(), frame.compressed.end());
+    }
+    return writer.bytes;
+}
+
+enum class ReplayStatus : uint8_t {
+    OK,
+    MALFORMED,
+    TOO_LONG,
+    CPU_LIMIT
+};
+
+// Keyframes are only read when asked for; validation re-simulates every
+// tick and never trusts them.
+ReplayStatus DecodeReplay(const uint8_t* data, size_t size, std::vector<InputFrame>& inputs, ReplayKeyframes* keyframes = nullptr) {
+    inputs.clear();
+    if (keyframes != nullptr) keyframes->frames.clear();
+
+    ByteReader reader(data, size);
+    if (reader.U32() != REPLAY_MAGIC) return ReplayStatus::MALFORMED;
+    uint16_t version = reader.U16();
+    if (version != REPLAY_VERSION && version != REPLAY_VERSION_WITHOUT_KEYFRAMES) return ReplayStatus::MALFORMED;
+    reader.U16();
+
+    uint32_t tickCount = reader.U32();
+    uint32_t runs = reader.U32();
+    if (!reader.Ok()) return ReplayStatus::MALFORMED;
+    if (tickCount > REPLAY_MAX_TICKS) return ReplayStatus::TOO_LONG;
+    if (runs > tickCount || runs * 2ull > reader.Remaining()) return ReplayStatus::MALFORMED;
+
+    inputs.reserve(tickCount);
+    for (uint32_t r = 0; r < runs; ++r) {
+        InputFrame frame;
+        int length = ReadInputRun(reader, frame);
+        if (!reader.Ok() || length == 0 || inputs.size() + length > tickCount) return ReplayStatus::MALFORMED;
+        inputs.insert(inputs.end(), length, frame);
+    }
+    if (inputs.size() != tickCount) return ReplayStatus::MALFORMED;
+    if (keyframes == nullptr || version == REPLAY_VERSION_WITHOUT_KEYFRAMES) return ReplayStatus::OK;
+
+    keyframes->interval = reader.U32();
+    uint32_t count = reader.U32();
+    if (!reader.Ok() || keyframes->interval < REPLAY_MIN_KEYFRAME_INTERVAL || count > tickCount / keyframes->interval ||
+        count > reader.Remaining() / REPLAY_KEYFRAME_ENTRY_BYTES) {
+        return ReplayStatus::MALFORMED;
+    }
+
+    std::vector<uint32_t> offsets(count);
+    keyframes->frames.resize(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        ReplayKeyframe& frame = keyframes->frames[i];
+        frame.tick = reader.U32();
+        frame.hash = reader.U64();
+        offsets[i] = reader.U32();
+        uint32_t length = reader.U32();
+        frame.rawSize = reader.U32();
+        bool ordered = i == 0 || frame.tick > keyframes->frames[i - 1].tick;
+        if (!reader.Ok() || !ordered || frame.tick > tickCount || length > reader.Remaining()) {
+            return ReplayStatus::MALFORMED;
+        }
+        frame.compressed.resize(length);
+    }
+
+    size_t blobs = reader.Remaining();
+    const uint8_t* base = reader.Bytes(blobs);
+    for (uint32_t i = 0; i < count; ++i) {
+        ReplayKeyframe& frame = keyframes->frames[i];
+        if ((uint64_t)offsets[i] + frame.compressed.size() > blobs) return ReplayStatus::MALFORMED;
+        if (!frame.compressed.empty()) memcpy(frame.compressed.data(), base + offsets[i], frame.compressed.size());
+    }
+    return ReplayStatus::OK;
+}
+
+bool SaveReplay(const std::vector<InputFrame>& inputs, const ReplayKeyframes& keyframes, const std::string& path) {
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+
+    std::vector<uint8_t> bytes = EncodeReplay(inputs, keyframes);
+    return SaveFileData(path.c_str(), bytes.data(), (int)bytes.size());
+}
+
+// Random access into a decoded replay. Seeking forward by less than one
+// keyframe interval steps on from where the world is; anything else starts
+// from the last keyframe at or before the target, so no seek simulates more
+// than about one interval of ticks.
+class ReplaySeeker {
+private:
+    GameWorld& world;
+    const std::vector<InputFrame>& inputs;
+    const ReplayKeyframes& keyframes;
+    std::vector<uint8_t> rejected;
+    WorldState pristine;
+    WorldState loaded;
+    uint32_t position = 0;
+
+    bool LoadKeyframe(int index) {
+        const ReplayKeyframe& frame = keyframes.frames[index];
+        int rawSize = 0;
+        unsigned char* raw = DecompressData(frame.compressed.data(), (int)frame.compressed.size(), &rawSize);
+        if (raw == nullptr) return false;
+
+        ByteReader reader(raw, (size_t)rawSize);
+        bool valid = (uint32_t)rawSize == frame.rawSize && ReadWorldState(reader, loaded) &&
+            world.catalog->Find(loaded.levelId) != LevelCatalog::NOT_FOUND;
+        MemFree(raw);
+        if (!valid) return false;
+
+        world.LoadState(loaded);
+        return world.StateHash() == frame.hash;
+    }
+
+public:
+    uint32_t lastSeekTicks = 0;
+
+    // The world must be freshly initialized, as for recording.
+    ReplaySeeker(GameWorld& replayWorld, const std::vector<InputFrame>& replayInputs, const ReplayKeyframes& replayKeyframes)
+        : world(replayWorld), inputs(replayInputs), keyframes(replayKeyframes), rejected(replayKeyframes.frames.size(), 0) {
+        world.SaveState(pristine);
+    }
+
+    uint32_t Position() const {
+        return position;
+    }
+
+    uint32_t Length() const {
+        return (uint32_t)inputs.size();
+    }
+
+    // Leaves the world as it was before input `target` was stepped.
+    void Seek(uint32_t target) {
+        target = std::min(target, Length());
+        lastSeekTicks = 0;
+
+        bool backwards = target < position;
+        if (backwards || target - position > keyframes.interval) {
+            // A keyframe behind the world only helps when going backwards.
+            bool loaded = false;
+            bool failed = false;
+            for (int index = keyframes.Before(target); index >= 0 && !loaded; --index) {
+                if (!backwards && keyframes.frames[index].tick <= position) break;
+                if (rejected[index]) continue;
+
+                loaded = LoadKeyframe(index);
+                if (loaded) {
+                    position = keyframes.frames[index].tick;
+                }
+                else {
+                    TraceLog(LOG_WARNING, "REPLAY: keyframe at tick %u does not load, skipped", keyframes.frames[index].tick);
+                    rejected[index] = 1;
+                    failed = true;
+                }
+            }
+
+            // A failed load may have left the world half overwritten.
+            if (!loaded && (backwards || failed)) {
+                world.LoadState(pristine);
+                position = 0;
+            }
+        }
+
+        for (; position < target; ++position) {
+            world.Step(inputs[position]);
+            lastSeekTicks++;
+        }
+    }
+};
+
+// AngryBirds --replay <file.abr>: plays a saved replay with a seek bar.
+int RunReplayViewer(const char* path) {
+    int size = 0;
+    unsigned char* data = LoadFileData(path, &size);
+    if (data == nullptr) {
+        TraceLog(LOG_ERROR, "REPLAY: could not read %s", path);
+        return 1;
+    }
+
+    std::vector<InputFrame> inputs;
+    ReplayKeyframes keyframes;
+    ReplayStatus status = DecodeReplay(data, (size_t)size, inputs, &keyframes);
+    UnloadFileData(data);
+    if (status != ReplayStatus::OK) {
+        TraceLog(LOG_ERROR, "REPLAY: %s is not a valid replay", path);
+        return 1;
+    }
+
+    GameWorld view;
+    view.Init();
+    ReplaySeeker seeker(view, inputs, keyframes);
+
+    const Rectangle bar = { 40.0f, WORLD_HEIGHT - 40.0f, WORLD_WIDTH - 80.0f, 12.0f };
+    bool playing = true;
+    bool dragging = false;
+    double seekMs = 0;
+
+    FrameGraph graph;
+    while (!WindowShouldClose() && !IsKeyPressed(KEY_ESCAPE)) {
+        Camera2D camera = WorldCamera();
+        Vector2 mouse = GetScreenToWorld2D(GetMousePosition(), camera);
+        uint32_t length = seeker.Length();
+        int64_t target = -1;
+
+        if (IsKeyPressed(KEY_SPACE)) playing = !playing;
+        if (IsKeyPressed(KEY_RIGHT)) target = (int64_t)seeker.Position() + REPLAY_KEYFRAME_INTERVAL;
+        if (IsKeyPressed(KEY_LEFT)) target = std::max<int64_t>(0, (int64_t)seeker.Position() - REPLAY_KEYFRAME_INTERVAL);
+        if (IsKeyPressed(KEY_HOME)) target = 0;
+        if (IsKeyPressed(KEY_END)) target = length;
+
+        Rectangle grab = { bar.x, bar.y - 10, bar.width, bar.height + 20 };
+        if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT) && CheckCollisionPointRec(mouse, grab)) dragging = true;
+        if (!IsMouseButtonDown(MOUSE_BUTTON_LEFT)) dragging = false;
+        if (dragging) {
+            float along = std::max(0.0f, std::min(1.0f, (mouse.x - bar.x) / bar.width));
+            target = std::lround(along * length);
+        }
+
+        if (target >= 0) {
+            auto start = std::chrono::steady_clock::now();
+            seeker.Seek((uint32_t)target);
+            seekMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+        else if (playing && seeker.Position() < length) {
+            seeker.Seek(seeker.Position() + 1);
+        }
+
+        FrameResource damage = view.AddPasses(graph, "Damage");
+        graph.AddPass("Screen", FRAME_BACKBUFFER, { damage }, 0, [&]() {
+            ClearBackground(BLACK);
+            BeginMode2D(camera);
+            view.Draw();
+
+            DrawRectangleRec(bar, { 0, 0, 0, 150 });
+            for (const ReplayKeyframe& frame : keyframes.frames) {
+                float x = bar.x + bar.width * frame.tick / std::max(1u, length);
+                DrawLine((int)x, (int)bar.y, (int)x, (int)(bar.y + bar.height), GRAY);
+            }
+            float head = bar.x + bar.width * seeker.Position() / std::max(1u, length);
+            DrawRectangle((int)bar.x, (int)bar.y, (int)(head - bar.x), (int)bar.height, { 255, 255, 255, 120 });
+            DrawCircle((int)head, (int)(bar.y + bar.height / 2), 9, WHITE);
+
+            int seconds = (int)(seeker.Position() / TICKS_PER_SECOND);
+            int totalSeconds = (int)(length / TICKS_PER_SECOND);
+            DrawText(TextFormat("%s  %d:%02d / %d:%02d  tick %u/%u", playing ? "REPLAY" : "PAUSED",
+                seconds / 60, seconds % 60, totalSeconds / 60, totalSeconds % 60, seeker.Position(), length),
+                (int)bar.x, (int)bar.y - 56, 20, WHITE);
+            DrawText(TextFormat("Space pause, Left/Right %d s, drag the bar to seek. Last seek: %u ticks, %.1f ms",
+                REPLAY_KEYFRAME_INTERVAL / TICKS_PER_SECOND, seeker.lastSeekTicks, seekMs),
+                (int)bar.x, (int)bar.y - 30, 16, LIGHTGRAY);
+            EndMode2D();
+        });
+        graph.Execute();
+    }
+    return 0;
+}
+
+struct ReplayResult {
+    ReplayStatus status = ReplayStatus::MALFORMED;
+    uint32_t level = 0;
+    bool completed = false;
+    int32_t levelScore = 0;
+    int32_t totalScore = 0;
+    uint32_t ticks = 0;
+    uint64_t hash = 0;
+};
+
+// Re-simulates replays headless. One validator per thread; the world is
+// rewound to its post-Init state between replays instead of rebuilt.
+class ReplayValidator {
+private:
+    GameWorld world;
+    WorldState pristine;
+    std::vector<InputFrame> inputs;
+
+public:
+    ReplayValidator() {
+        world.Init(false);
+        world.SaveState(pristine);
+    }
+
+    ReplayResult Validate(const uint8_t* data, size_t size, double cpuLimitSeconds) {
+        ReplayResult result;
+        result.status = DecodeReplay(data, size, inputs);
+        if (result.status != ReplayStatus::OK) return result;
+
+        world.LoadState(pristine);
+
+        double cpuStart = ThreadCpuSeconds();
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            world.Step(inputs[i]);
+
+            if ((i & 255) == 255 && ThreadCpuSeconds() - cpuStart > cpuLimitSeconds) {
+                result.status = ReplayStatus::CPU_LIMIT;
+                result.ticks = (uint32_t)(i + 1);
+                return result;
+            }
+        }
+
+        result.level = world.currentLevel.id;
+        result.completed = world.currentLevel.state == LevelState::COMPLETED;
+        result.levelScore = world.currentLevel.GetCurrentScore();
+        result.totalScore = world.totalScore;
+        result.ticks = (uint32_t)inputs.size();
+        result.hash = world.StateHash();
+        return result;
+    }
+};
+
+// Wire format, little-endian. Request: u32 id, u32 length, replay bytes.
+// Response: u32 id, u8 status, u8 completed, u16 0, u32 level, i32 level score,
+// i32 total score, u32 ticks, u64 state hash.
+constexpr uint32_t VALIDATION_MAX_REPLAY_BYTES = 4 * 1024 * 1024;
+constexpr size_t VALIDATION_RESPONSE_BYTES = 32;
+constexpr uint16_t VALIDATION_DEFAULT_PORT = 7780;
+
+std::vector<uint8_t> EncodeValidationResponse(uint32_t requestId, const ReplayResult& result) {
+    ByteWriter writer;
+    writer.U32(requestId);
+    writer.U8((uint8_t)result.status);
+    writer.U8(result.completed ? 1 : 0);
+    writer.U16(0);
+    writer.U32(result.level);
+    writer.U32((uint32_t)result.levelScore);
+    writer.U32((uint32_t)result.totalScore);
+    writer.U32(result.ticks);
+    writer.U64(result.hash);
+    return writer.bytes;
+}
+
+ReplayResult DecodeValidationResponse(const uint8_t* bytes, uint32_t& requestId) {
+    ByteReader reader(bytes, VALIDATION_RESPONSE_BYTES);
+    ReplayResult result;
+    requestId = reader.U32();
+    result.status = (ReplayStatus)reader.U8();
+    result.completed = reader.U8() != 0;
+    reader.U16();
+    result.level = reader.U32();
+    result.levelScore = (int32_t)reader.U32();
+    result.totalScore = (int32_t)reader.U32();
+    result.ticks = reader.U32();
+    result.hash = reader.U64();
+    return result;
+}
+
+struct ValidationConnection {
+    TcpSocket socket;
+    std::mutex writeMutex;
+};
+
+struct ValidationJob {
+    std::shared_ptr<ValidationConnection> connection;
+    uint32_t requestId = 0;
+    std::vector<uint8_t> replay;
+};
+
+// Accepts connections on the loopback interface; a reader thread per
+// connection queues requests and a fixed worker pool re-simulates them.
+// Requests may be pipelined, responses come back tagged with their id.
+class ReplayValidationService {
+private:
+    TcpSocket listener;
+    std::deque<ValidationJob> jobs;
+    std::mutex jobsMutex;
+    std::condition_variable jobsReady;
+    std::condition_variable jobsSpace;
+    size_t maxQueuedJobs = 0;
+    double cpuLimitSeconds = 0;
+    std::atomic<uint64_t> validated{ 0 };
+    std::atomic<uint64_t> rejected{ 0 };
+
+public:
+    int Run(uint16_t port, int workerCount, double cpuLimit) {
+        if (!NetStartup()) return 1;
+        if (!listener.Listen(port, true)) {
+            TraceLog(LOG_ERROR, "VALIDATOR: could not listen on port %d", port);
+            return 1;
+        }
+
+        cpuLimitSeconds = cpuLimit;
+        maxQueuedJobs = (size_t)workerCount * 64;
+
+        std::vector<std::thread> workers;
+        for (int i = 0; i < workerCount; ++i) {
+            workers.emplace_back([this] { WorkerLoop(); });
+        }
+        std::thread(&ReplayValidationService::ReportLoop, this).detach();
+
+        TraceLog(LOG_INFO, "VALIDATOR: listening on 127.0.0.1:%d with %d workers, %.0f ms CPU limit",
+            port, workerCount, cpuLimit * 1000.0);
+
+        while (true) {
+            auto connection = std::make_shared<ValidationConnection>();
+            if (!listener.Accept(connection->socket)) break;
+            std::thread(&ReplayValidationService::ReadLoop, this, connection).detach();
+        }
+
+        listener.Close();
+        NetShutdown();
+        return 0;
+    }
+
+private:
+    void ReadLoop(std::shared_ptr<ValidationConnection> connection) {
+        uint8_t header[8];
+        while (connection->socket.ReceiveAll(header, sizeof(header))) {
+            ByteReader reader(header, sizeof(header));
+            ValidationJob job;
+            job.connection = connection;
+            job.requestId = reader.U32();
+            uint32_t length = reader.U32();
+            if (length > VALIDATION_MAX_REPLAY_BYTES) break;
+
+            job.replay.resize(length);
+            if (!connection->socket.ReceiveAll(job.replay.data(), length)) break;
+
+            std::unique_lock<std::mutex> lock(jobsMutex);
+            jobsSpace.wait(lock, [this] { return jobs.size() < maxQueuedJobs; });
+            jobs.push_back(std::move(job));
+            lock.unlock();
+            jobsReady.notify_one();
+        }
+
+        std::lock_guard<std::mutex> lock(connection->writeMutex);
+        connection->socket.Close();
+    }
+
+    void WorkerLoop() {
+        ReplayValidator validator;
+
+        while (true) {
+            std::unique_lock<std::mutex> lock(jobsMutex);
+            jobsReady.wait(lock, [this] { return !jobs.empty(); });
+            ValidationJob job = std::move(jobs.front());
+            jobs.pop_front();
+            lock.unlock();
+            jobsSpace.notify_one();
+
+            ReplayResult result = validator.Validate(job.replay.data(), job.replay.size(), cpuLimitSeconds);
+            (result.status == ReplayStatus::OK ? validated : rejected)++;
+
+            std::vector<uint8_t> response = EncodeValidationResponse(job.requestId, result);
+            std::lock_guard<std::mutex> writeLock(job.connection->writeMutex);
+            if (job.connection->socket.IsOpen()) {
+                job.connection->socket.SendAll(response.data(), response.size());
+            }
+        }
+    }
+
+    void ReportLoop() {
+        uint64_t last = 0;
+        while (true) {
+            std::this_thread::sleep_for(std::chrono::seconds(5));
+            uint64_t total = validated + rejected;
+            if (total != last) {
+                TraceLog(LOG_INFO, "VALIDATOR: %.0f replays/s (%llu ok, %llu rejected)",
+                    (total - last) / 5.0, (unsigned long long)validated.load(), (unsigned long long)rejected.load());
+                last = total;
+            }
+        }
+    }
+};
+
+const char* ReplayStatusName(ReplayStatus status) {
+    switch (status) {
+    case ReplayStatus::OK: return "ok";
+    case ReplayStatus::MALFORMED: return "malformed";
+    case ReplayStatus::TOO_LONG: return "too long";
+    case ReplayStatus::CPU_LIMIT: return "cpu limit";
+    }
+    return "unknown";
+}
+
+// Sends one replay `repeat` times over a single pipelined connection and
+// prints the verdict and the achieved rate.
+int RunValidationClient(const char* replayPath, const char* host, uint16_t port, int repeat) {
+    int size = 0;
+    unsigned char* data = LoadFileData(replayPath, &size);
+    if (data == nullptr) return 1;
+    std::vector<uint8_t> replay(data, data + size);
+    UnloadFileData(data);
+
+    NetAddress address;
+    TcpSocket socket;
+    if (!NetStartup() || !ResolveAddress(host, port, address) || !socket.Connect(address)) {
+        TraceLog(LOG_ERROR, "VALIDATOR: could not connect to %s:%d", host, port);
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread sender([&] {
+        for (int i = 0; i < repeat; ++i) {
+            ByteWriter header;
+            header.U32((uint32_t)i);
+            header.U32((uint32_t)replay.size());
+            if (!socket.SendAll(header.bytes.data(), header.bytes.size()) ||
+                !socket.SendAll(replay.data(), replay.size())) {
+                break;
+            }
+        }
+    });
+
+    ReplayResult first;
+    int received = 0;
+    uint8_t response[VALIDATION_RESPONSE_BYTES];
+    while (received < repeat && socket.ReceiveAll(response, sizeof(response))) {
+        uint32_t requestId = 0;
+        ReplayResult result = DecodeValidationResponse(response, requestId);
+        if (received == 0) first = result;
+        received++;
+    }
+    sender.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%s: %s, level %u%s, score %d (total %d), %u ticks, hash %016llx\n", replayPath,
+        ReplayStatusName(first.status), first.level, first.completed ? " completed" : "",
+        first.levelScore, first.totalScore, first.ticks, (unsigned long long)first.hash);
+    if (repeat > 1) {
+        printf("%d validations in %.2f s (%.0f/s)\n", received, seconds, received / seconds);
+    }
+
+    socket.Close();
+    NetShutdown();
+    return received == repeat && first.status == ReplayStatus::OK ? 0 : 1;
+}
+
+// Spectator stream: one UDP datagram per tick that changed anything. Deltas
+// carry run-length encoded obstacle visibility flips, quantized projectile
+// transforms and the HUD when it changed; keyframes carry the full picture and
+// are cached so a spectator joining mid-stream replays from the last one.
+// No datagram is larger than SPECTATOR_MAX_DATAGRAM: a keyframe is split into
+// parts over consecutive obstacle ranges, and a delta that would not fit is
+// sent as a keyframe instead.
+constexpr uint16_t SPECTATOR_MAGIC = 0xAB04;
+constexpr size_t SPECTATOR_MAX_DATAGRAM = 1200;
+constexpr size_t SPECTATOR_MAX_PROJECTILES = 64;
+constexpr int SPECTATOR_MAX_POLL_ERRORS = 256;
+constexpr int SPECTATOR_KEYFRAME_INTERVAL = 2 * TICKS_PER_SECOND;
+constexpr int SPECTATOR_HEARTBEAT_INTERVAL = TICKS_PER_SECOND / 2;
+constexpr double SPECTATOR_TIMEOUT_SECONDS = 10.0;
+constexpr float SPECTATOR_POSITION_SCALE = 8.0f;
+constexpr float SPECTATOR_VELOCITY_SCALE = 256.0f;
+
+enum SpectatorMessage : uint8_t {
+    SPECTATOR_JOIN = 1,
+    SPECTATOR_KEYFRAME = 2,
+    SPECTATOR_DELTA = 3
+};
+
+enum SpectatorChanges : uint8_t {
+    CHANGE_VISIBILITY = 1 << 0,
+    CHANGE_HUD = 1 << 1,
+    CHANGE_PROJECTILES = 1 << 2
+};
+
+enum SpectatorHudFlags : uint8_t {
+    HUD_LAUNCHED = 1 << 0,
+    HUD_SELECTED = 1 << 1,
+    HUD_POWERUP_ACTIVE = 1 << 2,
+    HUD_CAN_USE_POWERUP = 1 << 3
+};
+
+struct SpectatorHud {
+    uint32_t level = 0;
+    uint8_t levelState = 0;
+    uint8_t attempts = 0;
+    uint8_t flags = 0;
+    int32_t totalScore = 0;
+
+    bool operator==(const SpectatorHud& other) const {
+        return level == other.level && levelState == other.levelState && attempts == other.attempts &&
+            flags == other.flags && totalScore == other.totalScore;
+    }
+};
+
+struct SpectatorProjectile {
+    int16_t x = 0, y = 0;
+    int16_t vx = 0, vy = 0;
+    uint8_t rotation = 0;
+    uint8_t radius = 0;
+    uint8_t flags = 0;
+
+    bool operator==(const SpectatorProjectile& other) const {
+        return x == other.x && y == other.y && vx == other.vx && vy == other.vy &&
+            rotation == other.rotation && radius == other.radius && flags == other.flags;
+    }
+};
+
+template <>
+struct Reflect<SpectatorHud> {
+    using Fields = FieldList<Field<&SpectatorHud::level, VarInt>, Field<&SpectatorHud::levelState>,
+        Field<&SpectatorHud::attempts>, Field<&SpectatorHud::flags>, Field<&SpectatorHud::totalScore>>;
+};
+
+template <>
+struct Reflect<SpectatorProjectile> {
+    using Fields = FieldList<Field<&SpectatorProjectile::x>, Field<&SpectatorProjectile::y>, Field<&SpectatorProjectile::vx>,
+        Field<&SpectatorProjectile::vy>, Field<&SpectatorProjectile::rotation>, Field<&SpectatorProjectile::radius>,
+        Field<&SpectatorProjectile::flags>>;
+};
+
+struct SpectatorFrame {
+    SpectatorHud hud;
+    std::vector<uint8_t> visible;
+    std::vector<SpectatorProjectile> projectiles;
+};
+
+SpectatorProjectile QuantizeBall(const Ball& b) {
+    SpectatorProjectile p;
+    p.x = (int16_t)lroundf(b.pos.x * SPECTATOR_POSITION_SCALE);
+    p.y = (int16_t)lroundf(b.pos.y * SPECTATOR_POSITION_SCALE);
+    p.vx = (int16_t)lroundf(fmaxf(-127.0f, fminf(127.0f, b.vel.x)) * SPECTATOR_VELOCITY_SCALE);
+    p.vy = (int16_t)lroundf(fmaxf(-127.0f, fminf(127.0f, b.vel.y)) * SPECTATOR_VELOCITY_SCALE);
+    p.rotation = (uint8_t)((int)lroundf(fmodf(b.rotationAngle, 360.0f) * 256.0f / 360.0f) & 0xFF);
+    p.radius = (uint8_t)lroundf(b.radius);
+    p.flags = (uint8_t)((b.isActive ? 1 : 0) | ((int)b.type << 1));
+    return p;
+}
+
+void ApplyProjectile(Ball& b, const SpectatorProjectile& p) {
+    b.pos = { p.x / SPECTATOR_POSITION_SCALE, p.y / SPECTATOR_POSITION_SCALE };
+    b.vel = { p.vx / SPECTATOR_VELOCITY_SCALE, p.vy / SPECTATOR_VELOCITY_SCALE };
+    b.rotationAngle = p.rotation * 360.0f / 256.0f;
+    b.radius = p.radius;
+    b.isActive = (p.flags & 1) != 0;
+    b.type = (BirdType)std::min(p.flags >> 1, BIRD_TYPE_COUNT - 1);
+}
+
+SpectatorFrame CaptureSpectatorFrame(GameWorld& world) {
+    SpectatorFrame frame;
+    frame.hud.level = world.currentLevel.id;
+    frame.hud.levelState = (uint8_t)world.currentLevel.state;
+    frame.hud.attempts = (uint8_t)world.attempts;
+    frame.hud.flags = (world.launched ? HUD_LAUNCHED : 0) | (world.selectedBall ? HUD_SELECTED : 0) |
+        (world.powerupActive ? HUD_POWERUP_ACTIVE : 0) | (world.canUsePowerup ? HUD_CAN_USE_POWERUP : 0);
+    frame.hud.totalScore = world.totalScore;
+
+    frame.visible.reserve(world.currentLevel.obstacles.size());
+    for (const auto& obs : world.currentLevel.obstacles) {
+        frame.visible.push_back(obs.visible ? 1 : 0);
+    }
+
+    frame.projectiles.push_back(QuantizeBall(world.ball));
+    world.projectiles.ForEach([&](const Ball& bird) {
+        if (frame.projectiles.size() < SPECTATOR_MAX_PROJECTILES) frame.projectiles.push_back(QuantizeBall(bird));
+    });
+    return frame;
+}
+
+// Alternating run lengths over the bits from begin, starting with a run of
+// zeros. Stops at a run boundary before the encoding passes maxBytes and
+// returns the index it stopped at.
+size_t WriteBitRuns(ByteWriter& writer, const std::vector<uint8_t>& bits, size_t begin = 0, size_t maxBytes = SIZE_MAX) {
+    ByteWriter runs;
+    uint32_t count = 0;
+    uint8_t current = 0;
+    size_t i = begin;
+    while (i < bits.size()) {
+        size_t end = i;
+        while (end < bits.size() && bits[end] == current) end++;
+
+        size_t before = runs.bytes.size();
+        runs.VarU32((uint32_t)(end - i));
+        if (i > begin && runs.bytes.size() + 5 > maxBytes) {
+            runs.bytes.resize(before);
+            break;
+        }
+        count++;
+        current ^= 1;
+        i = end;
+    }
+
+    writer.VarU32(count);
+    writer.bytes.insert(writer.bytes.end(), runs.bytes.begin(), runs.bytes.end());
+    return i;
+}
+
+bool ReadBitRuns(ByteReader& reader, std::vector<uint8_t>& bits, size_t count) {
+    bits.clear();
+    uint32_t runs = reader.VarU32();
+    uint8_t current = 0;
+    for (uint32_t r = 0; r < runs && reader.Ok(); ++r) {
+        uint32_t length = reader.VarU32();
+        if (bits.size() + length > count) return false;
+        bits.insert(bits.end(), length, current);
+        current ^= 1;
+    }
+    return reader.Ok() && bits.size() == count;
+}
+
+void WriteHud(ByteWriter& writer, const SpectatorHud& hud) {
+    Serialize(writer, hud);
+}
+
+void ReadHud(ByteReader& reader, SpectatorHud& hud) {
+    Deserialize(reader, hud);
+}
+
+void WriteProjectiles(ByteWriter& writer, const std::vector<SpectatorProjectile>& projectiles) {
+    writer.U8((uint8_t)projectiles.size());
+    SerializeItems(writer, projectiles.data(), projectiles.size());
+}
+
+void ReadProjectiles(ByteReader& reader, std::vector<SpectatorProjectile>& projectiles) {
+    projectiles.resize(reader.U8());
+    DeserializeItems(reader, projectiles.data(), projectiles.size());
+}
+
+class SpectatorEncoder {
+private:
+    SpectatorFrame last;
+    uint32_t sequence = 0;
+    uint32_t lastKeyframeTick = 0;
+    uint32_t lastSentTick = 0;
+    bool started = false;
+
+    void WriteHeader(ByteWriter& writer, SpectatorMessage type, uint32_t tick) {
+        writer.U16(SPECTATOR_MAGIC);
+        writer.U8(type);
+        writer.VarU32(++sequence);
+        writer.VarU32(tick);
+    }
+
+public:
+    // Appends the tick's datagrams to messages. Returns false when the tick
+    // changed nothing and no heartbeat is due.
+    bool Encode(const SpectatorFrame& frame, uint32_t tick, std::vector<std::vector<uint8_t>>& messages, bool& keyframe) {
+        keyframe = !started || frame.hud.level != last.hud.level || frame.visible.size() != last.visible.size() ||
+            tick - lastKeyframeTick >= SPECTATOR_KEYFRAME_INTERVAL;
+
+        if (!keyframe) {
+            uint8_t changes = 0;
+            std::vector<uint8_t> flipped(frame.visible.size());
+            bool anyFlipped = false;
+            for (size_t i = 0; i < frame.visible.size(); ++i) {
+                flipped[i] = frame.visible[i] ^ last.visible[i];
+                anyFlipped |= flipped[i] != 0;
+            }
+            if (anyFlipped) changes |= CHANGE_VISIBILITY;
+            if (!(frame.hud == last.hud)) changes |= CHANGE_HUD;
+            if (frame.projectiles != last.projectiles) changes |= CHANGE_PROJECTILES;
+
+            if (changes == 0 && tick - lastSentTick < SPECTATOR_HEARTBEAT_INTERVAL) return false;
+
+            ByteWriter writer;
+            WriteHeader(writer, SPECTATOR_DELTA, tick);
+            writer.U8(changes);
+            if (changes & CHANGE_VISIBILITY) WriteBitRuns(writer, flipped);
+            if (changes & CHANGE_HUD) WriteHud(writer, frame.hud);
+            if (changes & CHANGE_PROJECTILES) WriteProjectiles(writer, frame.projectiles);
+
+            if (writer.bytes.size() <= SPECTATOR_MAX_DATAGRAM) {
+                messages.push_back(std::move(writer.bytes));
+                last = frame;
+                lastSentTick = tick;
+                return true;
+            }
+            sequence--;
+            keyframe = true;
+        }
+
+        // The first part also carries the HUD and projectiles.
+        size_t first = 0;
+        do {
+            ByteWriter writer;
+            WriteHeader(writer, SPECTATOR_KEYFRAME, tick);
+            writer.VarU32((uint32_t)first);
+            writer.VarU32((uint32_t)frame.visible.size());
+            if (first == 0) {
+                WriteHud(writer, frame.hud);
+                WriteProjectiles(writer, frame.projectiles);
+            }
+
+            ByteWriter runs;
+            size_t end = WriteBitRuns(runs, frame.visible, first, SPECTATOR_MAX_DATAGRAM - writer.bytes.size() - 5);
+            writer.VarU32((uint32_t)(end - first));
+            writer.bytes.insert(writer.bytes.end(), runs.bytes.begin(), runs.bytes.end());
+            messages.push_back(std::move(writer.bytes));
+            first = end;
+        } while (first < frame.visible.size());
+
+        lastKeyframeTick = tick;
+        started = true;
+        last = frame;
+        lastSentTick = tick;
+        return true;
+    }
+};
+
+class SpectatorDecoder {
+private:
+    uint32_t sequence = 0;
+    std::vector<uint8_t> flipped;
+    std::vector<uint8_t> part;
+    SpectatorFrame pending;
+    size_t pendingFilled = 0;
+    bool assembling = false;
+
+public:
+    SpectatorFrame frame;
+    uint32_t tick = 0;
+    bool synced = false;
+
+    // Deltas are only applied on top of an unbroken chain from a keyframe,
+    // and a keyframe only once all of its parts arrived in sequence; after a
+    // lost datagram the decoder waits for the next keyframe.
+    bool Apply(const uint8_t* data, size_t size) {
+        ByteReader reader(data, size);
+        if (reader.U16() != SPECTATOR_MAGIC) return false;
+
+        uint8_t type = reader.U8();
+        uint32_t messageSequence = reader.VarU32();
+        uint32_t messageTick = reader.VarU32();
+
+        if (type == SPECTATOR_KEYFRAME) {
+            uint32_t first = reader.VarU32();
+            uint32_t count = reader.VarU32();
+            if (!reader.Ok() || count > LEVEL_MAX_OBSTACLES) return false;
+            if (first == 0) {
+                assembling = false;
+                pending.visible.clear();
+                ReadHud(reader, pending.hud);
+                ReadProjectiles(reader, pending.projectiles);
+                pendingFilled = 0;
+            }
+            else if (!assembling || messageSequence != sequence + 1 || first != pendingFilled ||
+                count != pending.visible.size()) {
+                assembling = false;
+                synced = false;
+                return false;
+            }
+
+            uint32_t length = reader.VarU32();
+            if (!reader.Ok() || length > count - first || !ReadBitRuns(reader, part, length)) {
+                assembling = false;
+                return false;
+            }
+            if (first == 0) pending.visible.resize(count);
+            std::copy(part.begin(), part.end(), pending.visible.begin() + first);
+            pendingFilled = first + length;
+            sequence = messageSequence;
+
+            assembling = pendingFilled < count;
+            synced = false;
+            if (assembling) return false;
+            frame = std::move(pending);
+        }
+        else if (type == SPECTATOR_DELTA) {
+            if (!synced || messageSequence != sequence + 1) {
+                assembling = false;
+                synced = false;
+                return false;
+            }
+
+            uint8_t changes = reader.U8();
+            if ((changes & CHANGE_VISIBILITY) && !ReadBitRuns(reader, flipped, frame.visible.size())) return false;
+            SpectatorHud hud = frame.hud;
+            if (changes & CHANGE_HUD) ReadHud(reader, hud);
+            std::vector<SpectatorProjectile> projectiles;
+            if (changes & CHANGE_PROJECTILES) ReadProjectiles(reader, projectiles);
+            if (!reader.Ok()) return false;
+
+            if (changes & CHANGE_VISIBILITY) {
+                for (size_t i = 0; i < flipped.size(); ++i) frame.visible[i] ^= flipped[i];
+            }
+            frame.hud = hud;
+            if (changes & CHANGE_PROJECTILES) frame.projectiles = std::move(projectiles);
+        }
+        else {
+            return false;
+        }
+
+        sequence = messageSequence;
+        tick = messageTick;
+        synced = true;
+        return true;
+    }
+};
+
+void ApplySpectatorFrame(GameWorld& world, const SpectatorFrame& frame) {
+    if (world.currentLevel.id != frame.hud.level) {
+        world.SetLevel(frame.hud.level);
+    }
+    // A level missing from this catalog has nothing to apply the frame to.
+    if (world.currentLevel.id != frame.hud.level) return;
+
+    auto& obstacles = world.currentLevel.obstacles;
+    bool changed = false;
+    for (size_t i = 0; i < obstacles.size() && i < frame.visible.size(); ++i) {
+        bool visible = frame.visible[i] != 0;
+        changed |= obstacles[i].visible != visible;
+        obstacles[i].visible = visible;
+    }
+    if (changed) world.currentLevel.runs.Invalidate();
+
+    world.currentLevel.state = (LevelState)frame.hud.levelState;
+    world.attempts = frame.hud.attempts;
+    world.totalScore = frame.hud.totalScore;
+    world.launched = (frame.hud.flags & HUD_LAUNCHED) != 0;
+    world.selectedBall = (frame.hud.flags & HUD_SELECTED) ? &world.ball : nullptr;
+    world.powerupActive = (frame.hud.flags & HUD_POWERUP_ACTIVE) != 0;
+    world.canUsePowerup = (frame.hud.flags & HUD_CAN_USE_POWERUP) != 0;
+
+    if (!frame.projectiles.empty()) {
+        ApplyProjectile(world.ball, frame.projectiles[0]);
+    }
+    world.projectiles.Clear();
+    for (size_t i = 1; i < frame.projectiles.size(); ++i) {
+        Ball bird = world.ball;
+        ApplyProjectile(bird, frame.projectiles[i]);
+        world.projectiles.Add(bird);
+    }
+}
+
+struct SpectatorSubscriber {
+    NetAddress address;
+    double lastSeen = 0;
+};
+
+// Publishes the local game to spectators that sent a JOIN datagram to the
+// spectator port. Spectators repeat JOIN as a keepalive.
+class SpectatorServer {
+private:
+    UdpSocket socket;
+    SpectatorEncoder encoder;
+    std::vector<SpectatorSubscriber> subscribers;
+    std::vector<std::vector<uint8_t>> sinceKeyframe;
+
+public:
+    bool Start(uint16_t port) {
+        return NetStartup() && socket.Open(port);
+    }
+
+    bool HasSubscribers() const {
+        return !subscribers.empty();
+    }
+
+    bool IsRunning() const {
+        return socket.IsOpen();
+    }
+
+    void Shutdown() {
+        if (!socket.IsOpen()) return;
+        socket.Close();
+        NetShutdown();
+    }
+
+    void Poll() {
+        if (!socket.IsOpen()) return;
+
+        uint8_t buffer[64];
+        NetAddress from;
+        double now = GetTime();
+        // Every send to a departed spectator can come back as an error here;
+        // skip those and keep reading so live spectators' joins still count.
+        int received;
+        int errors = 0;
+        while ((received = socket.ReceiveFrom(from, buffer, sizeof(buffer))) != 0) {
+            if (received < 0) {
+                if (++errors > SPECTATOR_MAX_POLL_ERRORS) break;
+                continue;
+            }
+            ByteReader reader(buffer, (size_t)received);
+            if (reader.U16() != SPECTATOR_MAGIC || reader.U8() != SPECTATOR_JOIN) continue;
+
+            auto it = std::find_if(subscribers.begin(), subscribers.end(),
+                [&](const SpectatorSubscriber& s) { return s.address == from; });
+            if (it != subscribers.end()) {
+                it->lastSeen = now;
+                continue;
+            }
+
+            subscribers.push_back({ from, now });
+            for (const auto& message : sinceKeyframe) {
+                socket.SendTo(from, message.data(), message.size());
+            }
+        }
+
+        subscribers.erase(std::remove_if(subscribers.begin(), subscribers.end(),
+            [&](const SpectatorSubscriber& s) { return now - s.lastSeen > SPECTATOR_TIMEOUT_SECONDS; }),
+            subscribers.end());
+    }
+
+    void Publish(GameWorld& world) {
+        if (!socket.IsOpen()) return;
+
+        std::vector<std::vector<uint8_t>> messages;
+        bool keyframe = false;
+        if (!encoder.Encode(CaptureSpectatorFrame(world), world.tick, messages, keyframe)) return;
+
+        if (keyframe) sinceKeyframe.clear();
+        for (const auto& message : messages) {
+            sinceKeyframe.push_back(message);
+            for (const auto& subscriber : subscribers) {
+                socket.SendTo(subscriber.address, message.data(), message.size());
+            }
+        }
+    }
+};
+
+int RunSpectator(const char* host, uint16_t port) {
+    NetAddress server;
+    UdpSocket socket;
+    if (!NetStartup() || !ResolveAddress(host, port, server) || !socket.Open(0)) {
+        TraceLog(LOG_ERROR, "SPECTATOR: could not reach %s:%d", host, port);
+        return 1;
+    }
+
+    GameWorld view;
+    view.Init();
+    SpectatorDecoder decoder;
+
+    ByteWriter join;
+    join.U16(SPECTATOR_MAGIC);
+    join.U8(SPECTATOR_JOIN);
+
+    double lastJoin = -SPECTATOR_TIMEOUT_SECONDS;
+    double startTime = GetTime();
+    size_t bytesReceived = 0;
+    bool hostUnreachable = false;
+    FrameGraph graph;
+
+    while (!WindowShouldClose() && !IsKeyPressed(KEY_ESCAPE)) {
+        if (GetTime() - lastJoin > 2.0) {
+            socket.SendTo(server, join.bytes.data(), join.bytes.size());
+            lastJoin = GetTime();
+        }
+
+        uint8_t buffer[SPECTATOR_MAX_DATAGRAM];
+        NetAddress from;
+        int received;
+        bool updated = false;
+        while ((received = socket.ReceiveFrom(from, buffer, sizeof(buffer))) > 0) {
+            if (!(from == server)) continue;
+            hostUnreachable = false;
+            bytesReceived += (size_t)received;
+            updated |= decoder.Apply(buffer, (size_t)received);
+        }
+        if (received < 0) {
+            hostUnreachable = true;
+        }
+        if (updated) {
+            ApplySpectatorFrame(view, decoder.frame);
+        }
+
+        FrameResource damage = view.AddPasses(graph, "Damage");
+        graph.AddPass("Screen", FRAME_BACKBUFFER, { damage }, 0, [&]() {
+            ClearBackground(BLACK);
+            BeginMode2D(WorldCamera());
+            if (decoder.synced || decoder.tick > 0) {
+                view.Draw();
+            }
+            else {
+                DrawRectangle(0, 0, (int)WORLD_WIDTH, (int)WORLD_HEIGHT, DARKGRAY);
+            }
+
+            double elapsed = GetTime() - startTime;
+            DrawRectangle((int)WORLD_WIDTH - 330, 130, 310, 54, { 0, 0, 0, 150 });
+            if (hostUnreachable) {
+                DrawText("Host unreachable", (int)WORLD_WIDTH - 320, 138, 20, RED);
+            }
+            else {
+                DrawText(decoder.synced ? "SPECTATING" : "Waiting for keyframe...", (int)WORLD_WIDTH - 320, 138, 20,
+                    decoder.synced ? WHITE : YELLOW);
+            }
+            DrawText(TextFormat("Tick %u  %.0f B/s", decoder.tick, elapsed > 0 ? bytesReceived / elapsed : 0.0),
+                (int)WORLD_WIDTH - 320, 162, 16, LIGHTGRAY);
+            EndMode2D();
+        });
+        graph.Execute();
+    }
+
+    graph.Release();
+    view.Destroy();
+    socket.Close();
+    NetShutdown();
+    return 0;
+}
+
+constexpr int DIFFICULTY_AIM_STEPS = 36;
+constexpr int DIFFICULTY_POWER_STEPS = 10;
+constexpr float DIFFICULTY_MAX_AIM_DEGREES = 85.0f;
+constexpr float DIFFICULTY_MIN_POWER = 0.1f;
+constexpr int DIFFICULTY_MAX_SHOT_TICKS = 30 * TICKS_PER_SECOND;
+constexpr int DIFFICULTY_SETTLE_TICKS = TICKS_PER_SECOND;
+constexpr int DIFFICULTY_CHUNK = 64;
+constexpr uint64_t DIFFICULTY_SEED = 0x6A09E667u;
+constexpr int DIFFICULTY_UNREACHABLE_TARGET = 1 << 30;
+constexpr double DIFFICULTY_WARN_COMPLETION = 0.05;
+
+// Aim is in radians above the horizontal, power is the fraction of the
+// maximum slingshot pull.
+struct ShotIntent {
+    float aim = 0;
+    float power = 0;
+};
+
+struct HumanErrorModel {
+    float aimSigmaDegrees = 3.0f;
+    float powerSigma = 0.08f;
+};
 
-    int powerupCost = 50;
-    bool canUsePowerup = false;
-    bool powerupActive = false;
-    Rectangle powerupButton;
+bool BallsMovingSideways(const GameWorld& world) {
+    if (world.ball.isActive && std::fabs(world.ball.vel.x) >= 0.1f) return true;
+    bool moving = false;
+    world.projectiles.ForEach([&](const Ball& bird) {
+        moving |= bird.isActive && std::fabs(bird.vel.x) >= 0.1f;
+    });
+    return moving;
+}
 
-    void Init() {
-        if (initialized) return;
+// Runs the world after a launch until the shot has settled. Returns false
+// if cancelled() asked to stop first; it is checked before every tick.
+template <class Cancelled>
+bool SettleShot(GameWorld& world, Cancelled cancelled) {
+    InputFrame idle;
+    int score = world.currentLevel.GetCurrentScore();
+    int quietTicks = 0;
+    for (int i = 0; i < DIFFICULTY_MAX_SHOT_TICKS && world.launched && quietTicks < DIFFICULTY_SETTLE_TICKS; ++i) {
+        if (cancelled()) return false;
+        world.Step(idle);
+
+        int newScore = world.currentLevel.GetCurrentScore();
+        quietTicks = newScore == score && !BallsMovingSideways(world) ? quietTicks + 1 : 0;
+        score = newScore;
+    }
+
+    // A ball that ends up bouncing in place never passes the rest check in
+    // Step(), so a shot that has stopped scoring is taken back here.
+    if (world.launched) {
+        world.ResetBalls();
+    }
+    return true;
+}
+
+// Plays one launch through Step() the way a player drags the slingshot, then
+// runs the world until the shot has settled.
+void PlayShot(GameWorld& world, const ShotIntent& shot) {
+    float power = std::max(0.0f, std::min(1.0f, shot.power));
+    float distance = power * LAUNCH_MAX_DISTANCE;
+
+    InputFrame press;
+    press.flags = INPUT_PRESS | INPUT_HOLD;
+    press.mouseX = (int16_t)world.xStart;
+    press.mouseY = (int16_t)world.yStart;
+    world.Step(press);
+
+    InputFrame pull;
+    pull.flags = INPUT_HOLD;
+    pull.mouseX = (int16_t)std::lround(world.xStart - std::cos(shot.aim) * distance);
+    pull.mouseY = (int16_t)std::lround(world.yStart + std::sin(shot.aim) * distance);
+    world.Step(pull);
+
+    InputFrame release;
+    release.flags = INPUT_RELEASE;
+    world.Step(release);
+
+    SettleShot(world, [] { return false; });
+}
+
+// The estimator plays every attempt out instead of stopping at the level's
+// own targetScore, so the score distribution can suggest a new one. Returns
+// the level's own targetScore.
+int SelectUncappedLevel(GameWorld& world, uint32_t level) {
+    InputFrame select;
+    select.flags = INPUT_SELECT;
+    select.level = level;
+    world.Step(select);
+    int targetScore = world.currentLevel.targetScore;
+    world.currentLevel.targetScore = DIFFICULTY_UNREACHABLE_TARGET;
+    return targetScore;
+}
 
-        staringTexture = LoadTexture("resources/meStaring.png");
-        surprisedTexture = LoadTexture("resources/meSurprised.png");
-        launchedTexture = LoadTexture("resources/meLaunched.png");
-        splitTexture = LoadTexture("resources/meSplit.png");
-        levelBackgroundTexture = LoadTexture("graphics/level_image.png");
-        powerupButtonTexture = LoadTexture("graphics/powerup_button.png");
+bool AllObstaclesDestroyed(const Level& level) {
+    for (const auto& obs : level.obstacles) {
+        if (obs.visible) return false;
+    }
+    return true;
+}
+
+ShotIntent GridShot(int index) {
+    int aimStep = index % DIFFICULTY_AIM_STEPS;
+    int powerStep = index / DIFFICULTY_AIM_STEPS;
+
+    ShotIntent shot;
+    shot.aim = toRadians(DIFFICULTY_MAX_AIM_DEGREES * aimStep / (DIFFICULTY_AIM_STEPS - 1));
+    shot.power = DIFFICULTY_MIN_POWER + (1.0f - DIFFICULTY_MIN_POWER) * (powerStep + 1) / DIFFICULTY_POWER_STEPS;
+    return shot;
+}
+
+// Greedy noiseless plan: for every attempt, the grid shot that destroys the
+// most blocks from where the previous shots left the level.
+std::vector<ShotIntent> PlanShots(GameWorld& world, const WorldState& start) {
+    std::vector<ShotIntent> plan;
+    WorldState current = start;
+
+    for (int attempt = 0; attempt < start.attempts; ++attempt) {
+        ShotIntent best;
+        int bestValue = -1;
+
+        for (int i = 0; i < DIFFICULTY_AIM_STEPS * DIFFICULTY_POWER_STEPS; ++i) {
+            world.LoadState(current);
+            PlayShot(world, GridShot(i));
 
-        if (splitTexture.id == 0) {
-            splitTexture = launchedTexture;
+            int value = world.currentLevel.GetCurrentScore();
+            if (value > bestValue) {
+                bestValue = value;
+                best = GridShot(i);
+            }
         }
 
-        powerupButton = { GetScreenWidth() - 150.0f, 60.0f, 100.0f, 40.0f };
+        world.LoadState(current);
+        PlayShot(world, best);
+        world.SaveState(current);
+        plan.push_back(best);
 
-        yStart = GetScreenHeight() - 200;
+        if (AllObstaclesDestroyed(world.currentLevel)) break;
+    }
 
-        ball.pos = { xStart, yStart };
-        ball.vel = { 50, -50 };
-        ball.radius = 40;
-        ball.friction = 0.99f;
-        ball.elasticity = 0.9f;
-        ball.rotationAngle = 0;
-        ball.staringTexture = staringTexture;
-        ball.surprisedTexture = surprisedTexture;
-        ball.launchedTexture = launchedTexture;
-        ball.splitTexture = splitTexture;
+    world.LoadState(current);
+    return plan;
+}
 
-        float groundY = GetScreenHeight() - 40;
+struct ShotPreviewResult {
+    uint32_t generation = 0;
+    uint32_t levelId = 0;
+    std::vector<uint32_t> fallen;
+    int gained = 0;
+};
 
-        level1.Initialize(groundY);
-        level2.Initialize(groundY);
-        level3.Initialize(groundY);
-        level4.Initialize(groundY);
+// Predicts what releasing the sling at the current pull would do, on a
+// worker thread with its own GameWorld. A new pull supersedes the one being
+// simulated, which stops at its next tick. The game thread only try_locks,
+// so it never waits on the simulation; a request or result that misses the
+// lock is handed over on a later frame.
+class ShotPreview {
+private:
+    GameWorld world;
+    std::thread worker;
+    std::atomic<uint32_t> generation{ 0 };
+
+    std::mutex requestMutex;
+    std::condition_variable requestReady;
+    WorldState request;
+    uint32_t requestGeneration = 0;
+    bool hasRequest = false;
+    bool quit = false;
+
+    std::mutex resultMutex;
+    ShotPreviewResult published;
+
+    // Game thread only.
+    WorldState queued;
+    bool queuedPending = false;
+    bool active = false;
+    Vector2 pull = {};
+    uint32_t pullGeneration = 0;
+    ShotPreviewResult shown;
+
+    void Run() {
+        world.Init(false);
+        WorldState state;
+        std::vector<uint8_t> visibleBefore;
+
+        for (;;) {
+            uint32_t job;
+            {
+                std::unique_lock<std::mutex> lock(requestMutex);
+                requestReady.wait(lock, [this] { return hasRequest || quit; });
+                if (quit) return;
+                std::swap(state, request);
+                job = requestGeneration;
+                hasRequest = false;
+            }
 
-        SetLevel(1);
+            // Uncapped so a shot that completes the level is not followed by
+            // the switch to the next one.
+            world.LoadState(state);
+            world.currentLevel.targetScore = DIFFICULTY_UNREACHABLE_TARGET;
+            visibleBefore = state.obstacleVisible;
+            int scoreBefore = world.currentLevel.GetCurrentScore();
+
+            InputFrame release;
+            release.flags = INPUT_RELEASE;
+            world.Step(release);
+            if (!SettleShot(world, [&] { return generation.load(std::memory_order_relaxed) != job; })) continue;
+
+            ShotPreviewResult result;
+            result.generation = job;
+            result.levelId = world.currentLevel.id;
+            result.gained = world.currentLevel.GetCurrentScore() - scoreBefore;
+            for (size_t i = 0; i < visibleBefore.size() && i < world.currentLevel.obstacles.size(); ++i) {
+                if (visibleBefore[i] && !world.currentLevel.obstacles[i].visible) result.fallen.push_back((uint32_t)i);
+            }
 
-        initialized = true;
+            std::lock_guard<std::mutex> lock(resultMutex);
+            published = std::move(result);
+        }
     }
 
-    void SetLevel(int levelNum) {
-        Reset();
+public:
+    ~ShotPreview() {
+        Stop();
+    }
 
-        switch (levelNum) {
-        case 1:
-            currentLevel = &level1;
-            break;
-        case 2:
-            currentLevel = &level2;
-            break;
-        case 3:
-            currentLevel = &level3;
-            break;
-        case 4:
-            currentLevel = &level4;
-            break;
-        default:
-            currentLevel = &level1;
-            break;
+    void Start() {
+        if (!worker.joinable()) worker = std::thread(&ShotPreview::Run, this);
+    }
+
+    void Stop() {
+        if (!worker.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(requestMutex);
+            quit = true;
+        }
+        generation++;
+        requestReady.notify_one();
+        worker.join();
+    }
+
+    // Called every frame of play after the step. Levels edited in place by
+    // --watch are not previewed: the worker loads levels from the catalog.
+    void Update(GameWorld& game) {
+        if (!worker.joinable()) return;
+
+        bool dragging = game.selectedBall != nullptr && !game.launched && !game.levelEdited;
+        if (!dragging) {
+            if (active) generation++;
+            active = false;
+            queuedPending = false;
+            return;
+        }
+
+        if (!active || game.ball.pos.x != pull.x || game.ball.pos.y != pull.y) {
+            pullGeneration = ++generation;
+            pull = game.ball.pos;
+            game.SaveState(queued);
+            queuedPending = true;
+            active = true;
         }
 
-        currentLevelIndex = levelNum;
-        attempts = 3;
-        currentLevel->Reset();
+        if (queuedPending && requestMutex.try_lock()) {
+            std::swap(request, queued);
+            requestGeneration = pullGeneration;
+            hasRequest = true;
+            requestMutex.unlock();
+            requestReady.notify_one();
+            queuedPending = false;
+        }
+
+        if (resultMutex.try_lock()) {
+            if (published.generation > shown.generation) shown = published;
+            resultMutex.unlock();
+        }
     }
 
-    void Destroy() {
-        UnloadTexture(staringTexture);
-        UnloadTexture(surprisedTexture);
-        UnloadTexture(launchedTexture);
-        UnloadTexture(splitTexture);
-        UnloadTexture(levelBackgroundTexture);
-        UnloadTexture(powerupButtonTexture);
-        initialized = false;
+    // True while the prediction for the current pull is still coming.
+    bool Busy() const {
+        return active && shown.generation != pullGeneration;
     }
 
-    void Update() {
-        if (currentLevel->state == LevelState::COMPLETED) {
-   
-            if (currentLevelIndex < 4) {
-             
-                static float completionTime = 0;
-                completionTime += GetFrameTime();
-
-                if (completionTime > 2.0f) {
-                    SetLevel(currentLevelIndex + 1);
-                    completionTime = 0;
+    // Outlines the blocks the shot would knock down and the points it would
+    // score. A prediction for an earlier pull stays up, faded, until the
+    // current one arrives.
+    void Draw(const GameWorld& game) const {
+        if (!active || shown.generation == 0 || shown.levelId != game.currentLevel.id) return;
+
+        unsigned char alpha = shown.generation == pullGeneration ? 220 : 90;
+        Color outline = { 230, 41, 55, alpha };
+        for (uint32_t index : shown.fallen) {
+            if (index >= game.currentLevel.obstacles.size()) continue;
+            DrawRectangleLinesEx(game.currentLevel.obstacles[index].rect, 3.0f, outline);
+            drawSubmissions++;
+        }
+        DrawText(TextFormat("+%d  (%d blocks)", shown.gained, (int)shown.fallen.size()),
+            (int)game.xStart - 60, (int)game.yStart + 70, 20, { 0, 0, 0, alpha });
+    }
+};
+
+struct DifficultyTally {
+    int64_t games = 0;
+    int64_t completed = 0;
+    int64_t shotsToComplete = 0;
+    std::vector<int64_t> scoreHistogram;
+
+    void AddScore(int score) {
+        size_t bin = (size_t)(score / 10);
+        if (bin >= scoreHistogram.size()) scoreHistogram.resize(bin + 1, 0);
+        scoreHistogram[bin]++;
+    }
+
+    void Merge(const DifficultyTally& other) {
+        games += other.games;
+        completed += other.completed;
+        shotsToComplete += other.shotsToComplete;
+        if (other.scoreHistogram.size() > scoreHistogram.size()) scoreHistogram.resize(other.scoreHistogram.size(), 0);
+        for (size_t i = 0; i < other.scoreHistogram.size(); ++i) scoreHistogram[i] += other.scoreHistogram[i];
+    }
+
+    // Highest score that at least the given fraction of games reached.
+    int ScoreReachedBy(double fraction) const {
+        int64_t reached = 0;
+        for (int bin = (int)scoreHistogram.size() - 1; bin >= 0; --bin) {
+            reached += scoreHistogram[bin];
+            if (reached >= fraction * games) return bin * 10;
+        }
+        return 0;
+    }
+};
+
+// Replays the plan with every shot perturbed by the error model. Each game
+// draws from its own stream, so results do not depend on the thread count.
+void PlayNoisyGames(const WorldState& start, const std::vector<ShotIntent>& plan, const HumanErrorModel& model,
+    uint32_t level, int targetScore, int games, std::atomic<int>& nextGame, DifficultyTally& tally) {
+    GameWorld world;
+    world.Init(false);
+    SelectUncappedLevel(world, level);
+
+    float aimSigma = toRadians(model.aimSigmaDegrees);
+
+    for (;;) {
+        int first = nextGame.fetch_add(DIFFICULTY_CHUNK);
+        if (first >= games) break;
+
+        for (int game = first; game < std::min(games, first + DIFFICULTY_CHUNK); ++game) {
+            RandomStream rng(DIFFICULTY_SEED, RANDOM_DIFFICULTY, level, (uint32_t)game);
+            world.LoadState(start);
+
+            int shots = 0;
+            int completedAfter = 0;
+            while (shots < start.attempts && !AllObstaclesDestroyed(world.currentLevel)) {
+                ShotIntent shot = plan[std::min((size_t)shots, plan.size() - 1)];
+                shot.aim += aimSigma * rng.NextNormal();
+                shot.power *= 1.0f + model.powerSigma * rng.NextNormal();
+                PlayShot(world, shot);
+                shots++;
+
+                if (completedAfter == 0 && world.currentLevel.GetCurrentScore() >= targetScore) {
+                    completedAfter = shots;
                 }
             }
-            return;
+
+            tally.games++;
+            tally.completed += completedAfter > 0 ? 1 : 0;
+            tally.shotsToComplete += completedAfter;
+            tally.AddScore(world.currentLevel.GetCurrentScore());
+        }
+    }
+}
+
+// Estimates how hard each level is for a player whose aim and pull strength
+// are off by the given normal errors, and suggests a targetScore that the
+// requested share of such players reaches.
+int RunDifficultyEstimate(int games, int workers, const HumanErrorModel& model, double parRate) {
+    GameWorld world;
+    world.Init(false);
+    int warnings = 0;
+
+    printf("difficulty: %d games per level, aim sigma %.1f deg, power sigma %.0f%%, %d threads\n",
+        games, model.aimSigmaDegrees, model.powerSigma * 100.0f, workers);
+
+    for (size_t index = 0; index < world.catalog->Count(); ++index) {
+        uint32_t level = world.catalog->IdAt(index);
+        int targetScore = SelectUncappedLevel(world, level);
+
+        WorldState start;
+        world.SaveState(start);
+
+        auto startTime = std::chrono::steady_clock::now();
+        std::vector<ShotIntent> plan = PlanShots(world, start);
+        int planScore = world.currentLevel.GetCurrentScore();
+        bool solvable = planScore >= targetScore;
+
+        std::atomic<int> nextGame{ 0 };
+        std::vector<DifficultyTally> tallies(workers);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < workers; ++i) {
+            threads.emplace_back(PlayNoisyGames, std::cref(start), std::cref(plan), std::cref(model),
+                level, targetScore, games, std::ref(nextGame), std::ref(tallies[i]));
         }
 
-        
-        totalScore = level1.GetCurrentScore() + level2.GetCurrentScore() + level3.GetCurrentScore() + level4.GetCurrentScore();
+        DifficultyTally tally;
+        for (int i = 0; i < workers; ++i) {
+            threads[i].join();
+            tally.Merge(tallies[i]);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+        double completion = tally.games > 0 ? (double)tally.completed / tally.games : 0.0;
+        printf("\nLevel %u \"%s\" (targetScore %d)\n", level, world.currentLevel.name.c_str(), targetScore);
+        printf("  planned shots:      %zu, %d points\n", plan.size(), planScore);
+        printf("  completion:         %.1f%% within %d attempts", 100.0 * completion, start.attempts);
+        if (tally.completed > 0) printf(", %.2f shots on average", (double)tally.shotsToComplete / tally.completed);
+        printf("\n");
+        printf("  final score:        p10 %d, p50 %d, p90 %d\n",
+            tally.ScoreReachedBy(0.9), tally.ScoreReachedBy(0.5), tally.ScoreReachedBy(0.1));
+        printf("  suggested target:   %d (reached by %.0f%% of players)\n", tally.ScoreReachedBy(parRate), parRate * 100.0);
+        printf("  simulated in %.2f s\n", seconds);
+
+        if (!solvable) {
+            printf("  WARNING: no planned shot sequence reaches targetScore %d\n", targetScore);
+            warnings++;
+        }
+        else if (completion < DIFFICULTY_WARN_COMPLETION) {
+            printf("  WARNING: fewer than %.0f%% of players complete this level\n", DIFFICULTY_WARN_COMPLETION * 100.0);
+            warnings++;
+        }
+    }
 
-  
-        canUsePowerup = totalScore >= powerupCost;
+    return warnings > 0 ? 2 : 0;
+}
 
+constexpr int FARM_MAX_WORKERS = 64;
+constexpr uint32_t FARM_RING_CAPACITY = 1024;
+constexpr int FARM_MAX_ATTEMPTS = 3;
+constexpr int64_t FARM_JOB_TIMEOUT_MS = 60 * 1000;
+constexpr int64_t FARM_ORPHAN_TIMEOUT_MS = 10 * 1000;
+constexpr int64_t FARM_LOST_JOB_MS = 5 * 1000;
+constexpr int64_t FARM_SHUTDOWN_MS = 5 * 1000;
+constexpr uint32_t FARM_MAGIC = 0x4D524146;
+constexpr int FARM_WORKER_UNUSABLE = 64;
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<int64_t>::is_always_lock_free,
+    "farm queues live in shared memory and need address-free atomics");
+
+// One grid shot (see GridShot) from the start of a level.
+struct FarmJob {
+    int32_t id = 0;
+    uint32_t level = 0;
+    int32_t shot = 0;
+};
 
-        if (launched && canUsePowerup && !powerupActive && !ball.isSplit && ball.isActive) {
-            if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
-  
-                ActivateSplitPowerup();
+struct FarmResult {
+    int32_t id = 0;
+    ShotRecord shot;
+};
+
+// Bounded MPMC queue (Vyukov) that works across processes: no pointers,
+// only atomics on the cells. A worker is only ever killed inside a job, so
+// none dies between claiming a cell and publishing it.
+template <class T, uint32_t N>
+struct FarmRing {
+    static_assert((N & (N - 1)) == 0, "ring capacity must be a power of two");
+
+    struct Cell {
+        std::atomic<uint32_t> sequence;
+        T value;
+    };
+
+    alignas(64) std::atomic<uint32_t> head;
+    alignas(64) std::atomic<uint32_t> tail;
+    alignas(64) Cell cells[N];
+
+    void Init() {
+        for (uint32_t i = 0; i < N; ++i) cells[i].sequence.store(i, std::memory_order_relaxed);
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_release);
+    }
+
+    bool TryPush(const T& value) {
+        uint32_t pos = head.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & (N - 1)];
+            int32_t lag = (int32_t)(cell.sequence.load(std::memory_order_acquire) - pos);
+            if (lag == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = value;
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (lag < 0) {
+                return false;
+            }
+            else {
+                pos = head.load(std::memory_order_relaxed);
             }
         }
+    }
 
-        if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
-            Vector2 mousePos = GetMousePosition();
-            if (CheckCollisionPointCircle(mousePos, ball.pos, ball.radius) && !launched) {
-                selectedBall = &ball;
-                xOffset = mousePos.x - ball.pos.x;
-                yOffset = mousePos.y - ball.pos.y;
+    bool TryPop(T& value) {
+        uint32_t pos = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & (N - 1)];
+            int32_t lag = (int32_t)(cell.sequence.load(std::memory_order_acquire) - (pos + 1));
+            if (lag == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = cell.value;
+                    cell.sequence.store(pos + N, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (lag < 0) {
+                return false;
+            }
+            else {
+                pos = tail.load(std::memory_order_relaxed);
             }
         }
+    }
 
-        if (IsMouseButtonDown(MOUSE_BUTTON_LEFT) && selectedBall) {
-            Vector2 mousePos = GetMousePosition();
-            ball.pos.x = mousePos.x - xOffset;
-            ball.pos.y = mousePos.y - yOffset;
+    bool Empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+};
+
+// What each worker is doing, so the coordinator can requeue the job of a
+// worker that crashed and kill one that hangs.
+struct FarmWorkerSlot {
+    std::atomic<int32_t> job;
+    std::atomic<int64_t> jobStartMs;
+};
+
+struct FarmShared {
+    uint32_t magic;
+    std::atomic<uint32_t> stop;
+    std::atomic<int64_t> heartbeatMs;
+    FarmWorkerSlot workers[FARM_MAX_WORKERS];
+    FarmRing<FarmJob, FARM_RING_CAPACITY> jobs;
+    FarmRing<FarmResult, FARM_RING_CAPACITY> results;
+};
+
+// Steady clock time that all processes on the machine agree on.
+int64_t FarmClockMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Plays one grid shot from the start of the level that world was last
+// selected on and describes it the way a live session logs a launch.
+ShotRecord EvaluateFarmJob(GameWorld& world, const WorldState& start, int targetScore, const FarmJob& job) {
+    world.LoadState(start);
+    ShotIntent shot = GridShot(job.shot);
+    float distance = std::max(0.0f, std::min(1.0f, shot.power)) * LAUNCH_MAX_DISTANCE;
+
+    auto visible = [&world]() {
+        int count = 0;
+        for (const auto& obs : world.currentLevel.obstacles) count += obs.visible ? 1 : 0;
+        return count;
+    };
+    int visibleBefore = visible();
+    uint32_t startTick = world.tick;
+
+    PlayShot(world, shot);
+
+    ShotRecord record;
+    record.level = (int32_t)job.level;
+    record.dragX = -std::cos(shot.aim) * distance;
+    record.dragY = std::sin(shot.aim) * distance;
+    record.blocksDestroyed = visibleBefore - visible();
+    record.finalScore = world.currentLevel.GetCurrentScore();
+    record.completed = record.finalScore >= targetScore ? 1 : 0;
+    record.flightTicks = (int32_t)(world.tick - startTick);
+    return record;
+}
+
+// A farm worker process: takes jobs from the shared queue until told to
+// stop, or until the coordinator stops beating.
+int RunFarmWorker(const std::string& name, int slot, int core) {
+    SharedMemory memory;
+    if (slot < 0 || slot >= FARM_MAX_WORKERS || !memory.Open(name, sizeof(FarmShared))) return FARM_WORKER_UNUSABLE;
+    FarmShared* shared = static_cast<FarmShared*>(memory.Data());
+    if (shared->magic != FARM_MAGIC) return FARM_WORKER_UNUSABLE;
+
+    PinCurrentThread(core);
+    FarmWorkerSlot& self = shared->workers[slot];
+
+    GameWorld world;
+    world.Init(false);
+    WorldState start;
+    uint32_t startLevel = 0;
+    int targetScore = 0;
+
+    while (!shared->stop.load()) {
+        if (FarmClockMs() - shared->heartbeatMs.load() > FARM_ORPHAN_TIMEOUT_MS) return 0;
+
+        FarmJob job;
+        if (!shared->jobs.TryPop(job)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        self.jobStartMs.store(FarmClockMs());
+        self.job.store(job.id);
+
+        if (job.level != startLevel) {
+            targetScore = SelectUncappedLevel(world, job.level);
+            world.SaveState(start);
+            startLevel = job.level;
+        }
+
+        FarmResult result;
+        result.id = job.id;
+        result.shot = EvaluateFarmJob(world, start, targetScore, job);
+        while (!shared->results.TryPush(result)) {
+            if (shared->stop.load()) return 0;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        self.job.store(-1);
+    }
+    return 0;
+}
+
+// Evaluates every grid shot of every level in worker processes, so a level
+// that crashes or hangs the simulation costs one worker restart rather than
+// the run. Each job is retried on a fresh worker up to FARM_MAX_ATTEMPTS
+// times before it is skipped. Results are appended to a shot log.
+int RunSimulationFarm(const std::string& outPath, int workers, const std::string& packPath) {
+    workers = std::max(1, std::min(FARM_MAX_WORKERS, workers));
+
+    LevelCatalog& catalog = ActiveCatalog();
+    std::vector<FarmJob> jobs;
+    for (size_t index = 0; index < catalog.Count(); ++index) {
+        for (int shot = 0; shot < DIFFICULTY_AIM_STEPS * DIFFICULTY_POWER_STEPS; ++shot) {
+            FarmJob job;
+            job.id = (int32_t)jobs.size();
+            job.level = catalog.IdAt(index);
+            job.shot = shot;
+            jobs.push_back(job);
+        }
+    }
+
+    std::string name = "angrybirds_farm_" + std::to_string(CurrentProcessId());
+    SharedMemory memory;
+    if (!memory.Create(name, sizeof(FarmShared))) {
+        fprintf(stderr, "farm: could not create shared memory %s\n", name.c_str());
+        return 1;
+    }
+    FarmShared* shared = new (memory.Data()) FarmShared();
+    shared->jobs.Init();
+    shared->results.Init();
+    for (FarmWorkerSlot& slot : shared->workers) slot.job.store(-1);
+    shared->heartbeatMs.store(FarmClockMs());
+    shared->magic = FARM_MAGIC;
+
+    std::error_code error;
+    std::filesystem::path parent = std::filesystem::path(outPath).parent_path();
+    if (!parent.empty()) std::filesystem::create_directories(parent, error);
+    ShotLogWriter log;
+    if (!log.Open(outPath)) {
+        fprintf(stderr, "farm: could not open %s\n", outPath.c_str());
+        return 1;
+    }
+
+    std::vector<int> cores = CoresByNumaNode();
+    std::string executable = ExecutablePath();
+    std::vector<ChildProcess> children(workers);
+    std::vector<uint8_t> killed(workers, 0);
+    auto startWorker = [&](int slot) {
+        std::vector<std::string> args = { executable, "--farm-worker", name, std::to_string(slot),
+            std::to_string(cores[slot % cores.size()]) };
+        if (!packPath.empty()) {
+            args.push_back("--pack");
+            args.push_back(packPath);
+        }
+        return children[slot].Start(args);
+    };
+
+    printf("farm: %zu shots over %zu levels, %d worker processes\n", jobs.size(), catalog.Count(), workers);
+    auto startTime = std::chrono::steady_clock::now();
+    for (int slot = 0; slot < workers; ++slot) {
+        if (!startWorker(slot)) {
+            fprintf(stderr, "farm: could not start worker process %s\n", executable.c_str());
+            shared->stop.store(1);
+            return 1;
+        }
+    }
+
+    std::deque<int32_t> pending;
+    for (const FarmJob& job : jobs) pending.push_back(job.id);
+    std::vector<uint8_t> done(jobs.size(), 0);
+    std::vector<uint8_t> attempts(jobs.size(), 0);
+    size_t finished = 0;
+    size_t skipped = 0;
+    int restarts = 0;
+    int64_t lastProgressMs = FarmClockMs();
+
+    while (finished < jobs.size()) {
+        int64_t now = FarmClockMs();
+        shared->heartbeatMs.store(now);
+        bool busy = false;
+
+        while (!pending.empty() && shared->jobs.TryPush(jobs[pending.front()])) {
+            pending.pop_front();
+            busy = true;
+        }
+
+        FarmResult result;
+        while (shared->results.TryPop(result)) {
+            busy = true;
+            lastProgressMs = now;
+            if (done[result.id]) continue;
+            done[result.id] = 1;
+            finished++;
+            log.Append(result.shot);
+        }
+
+        bool anyWorking = false;
+        for (int slot = 0; slot < workers; ++slot) {
+            FarmWorkerSlot& worker = shared->workers[slot];
+            int32_t job = worker.job.load();
+            if (job >= 0 && !killed[slot] && now - worker.jobStartMs.load() > FARM_JOB_TIMEOUT_MS) {
+                printf("farm: level %u shot %d timed out, killing worker %d\n", jobs[job].level, jobs[job].shot, slot);
+                children[slot].Kill();
+                killed[slot] = 1;
+            }
+            if (children[slot].Running()) {
+                anyWorking |= job >= 0;
+                continue;
+            }
+
+            if (children[slot].ExitCode() == FARM_WORKER_UNUSABLE) {
+                fprintf(stderr, "farm: worker %d could not attach to the shared queue\n", slot);
+                shared->stop.store(1);
+                return 1;
+            }
+
+            job = worker.job.exchange(-1);
+            if (job >= 0 && !done[job]) {
+                if (++attempts[job] >= FARM_MAX_ATTEMPTS) {
+                    printf("farm: level %u shot %d failed %d times, skipped\n", jobs[job].level, jobs[job].shot, FARM_MAX_ATTEMPTS);
+                    done[job] = 1;
+                    finished++;
+                    skipped++;
+                }
+                else {
+                    pending.push_front(job);
+                }
+            }
+
+            killed[slot] = 0;
+            restarts++;
+            printf("farm: worker %d exited with code %d, restarting\n", slot, children[slot].ExitCode());
+            if (!startWorker(slot)) {
+                fprintf(stderr, "farm: could not restart worker %d\n", slot);
+                shared->stop.store(1);
+                return 1;
+            }
+            busy = true;
+        }
+
+        // A worker that died right after taking a job, before it published
+        // which one, leaves it unaccounted for; once everything is quiet
+        // the jobs without results go round again.
+        if (pending.empty() && !anyWorking && shared->jobs.Empty() && now - lastProgressMs > FARM_LOST_JOB_MS) {
+            for (const FarmJob& job : jobs) {
+                if (!done[job.id]) pending.push_back(job.id);
+            }
+            lastProgressMs = now;
+        }
+
+        if (!busy) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    shared->stop.store(1);
+    int64_t stopMs = FarmClockMs();
+    for (ChildProcess& child : children) {
+        while (child.Running()) {
+            if (FarmClockMs() - stopMs > FARM_SHUTDOWN_MS) child.Kill();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    log.Close();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    printf("farm: %zu shots in %.1f s (%.0f/s), %d worker restarts, %zu skipped; results in %s\n",
+        finished - skipped, seconds, (finished - skipped) / std::max(seconds, 1e-9), restarts, skipped, outPath.c_str());
+    return skipped > 0 ? 2 : 0;
+}
+
+BirdType BirdTypeFromName(const std::string& name, bool& found) {
+    for (int type = 0; type < BIRD_TYPE_COUNT; ++type) {
+        const char* traitName = BIRD_TRAITS[type].name;
+        if (name.size() == strlen(traitName) && std::equal(name.begin(), name.end(), traitName,
+            [](char a, char b) { return tolower((unsigned char)a) == tolower((unsigned char)b); })) {
+            found = true;
+            return (BirdType)type;
+        }
+    }
+    found = false;
+    return BirdType::NORMAL;
+}
+
+// Plain-text level source that packs are built from:
+//   id 12
+//   name Leaning Tower
+//   target 150
+//   birds normal heavy explosive
+//   block <x> <y> <width> <height> <fill RRGGBBAA> <stroke RRGGBBAA>
+// Blank lines and lines starting with # are ignored.
+bool ParseLevelFile(const std::string& path, Level& level) {
+    FILE* file = fopen(path.c_str(), "r");
+    if (file == nullptr) {
+        fprintf(stderr, "%s: cannot open\n", path.c_str());
+        return false;
+    }
+
+    level = Level();
+    int birds = 0;
+    int lineNumber = 0;
+    bool ok = true;
+    char line[512];
+    while (ok && fgets(line, sizeof(line), file) != nullptr) {
+        lineNumber++;
+        std::string text = line;
+        while (!text.empty() && (text.back() == '\n' || text.back() == '\r' || text.back() == ' ')) text.pop_back();
+        if (text.empty() || text[0] == '#') continue;
+
+        char keyword[16] = {};
+        int consumed = 0;
+        sscanf(text.c_str(), "%15s %n", keyword, &consumed);
+        const char* rest = text.c_str() + consumed;
+
+        Rectangle rect;
+        unsigned int fill = 0, stroke = 0;
+        if (strcmp(keyword, "id") == 0) {
+            level.id = (uint32_t)strtoul(rest, nullptr, 10);
+        }
+        else if (strcmp(keyword, "name") == 0) {
+            level.name = rest;
+            ok = level.name.size() < LEVEL_NAME_BYTES;
+        }
+        else if (strcmp(keyword, "target") == 0) {
+            level.targetScore = atoi(rest);
+        }
+        else if (strcmp(keyword, "birds") == 0) {
+            char names[BIRDS_PER_LEVEL + 1][16] = {};
+            birds = sscanf(rest, "%15s %15s %15s %15s", names[0], names[1], names[2], names[3]);
+            ok = birds == BIRDS_PER_LEVEL;
+            for (int i = 0; ok && i < BIRDS_PER_LEVEL; ++i) {
+                level.birds[i] = BirdTypeFromName(names[i], ok);
+            }
+        }
+        else if (strcmp(keyword, "block") == 0 &&
+            sscanf(rest, "%f %f %f %f %x %x", &rect.x, &rect.y, &rect.width, &rect.height, &fill, &stroke) == 6) {
+            level.obstacles.push_back(Obstacle(rect, true, ColorFromHex(fill), ColorFromHex(stroke)));
+        }
+        else {
+            ok = false;
+        }
+
+        if (!ok) fprintf(stderr, "%s:%d: cannot parse \"%s\"\n", path.c_str(), lineNumber, text.c_str());
+    }
+    fclose(file);
+
+    if (ok && (level.id == 0 || level.name.empty() || level.targetScore <= 0 || birds != BIRDS_PER_LEVEL ||
+        level.obstacles.empty() || level.obstacles.size() > LEVEL_MAX_OBSTACLES)) {
+        fprintf(stderr, "%s: needs an id, name, target, %d birds and 1-%u blocks\n", path.c_str(), BIRDS_PER_LEVEL, LEVEL_MAX_OBSTACLES);
+        ok = false;
+    }
+    return ok;
+}
+
+bool WriteLevelFile(const std::string& path, const Level& level) {
+    FILE* file = fopen(path.c_str(), "w");
+    if (file == nullptr) return false;
+
+    fprintf(file, "id %u\nname %s\ntarget %d\nbirds", level.id, level.name.c_str(), level.targetScore);
+    for (BirdType bird : level.birds) fprintf(file, " %s", BIRD_TRAITS[(int)bird].name);
+    fprintf(file, "\n");
+    for (const auto& obs : level.obstacles) {
+        fprintf(file, "block %.9g %.9g %.9g %.9g %08X %08X\n", obs.rect.x, obs.rect.y, obs.rect.width, obs.rect.height,
+            HexFromColor(obs.fillColor), HexFromColor(obs.strokeColor));
+    }
+    return fclose(file) == 0;
+}
+
+void AppendCompressed(ByteWriter& writer, const void* data, size_t size, uint32_t& offset, uint32_t& compressedSize) {
+    int length = 0;
+    unsigned char* compressed = CompressData(static_cast<const unsigned char*>(data), (int)size, &length);
+    offset = (uint32_t)writer.bytes.size();
+    compressedSize = (uint32_t)length;
+    writer.bytes.insert(writer.bytes.end(), compressed, compressed + length);
+    MemFree(compressed);
+}
+
+// Builds a level pack from .lvl files and directories of them.
+int RunPackLevels(const std::string& outPath, const std::vector<std::string>& inputs) {
+    std::vector<std::string> files;
+    for (const auto& input : inputs) {
+        std::error_code error;
+        if (std::filesystem::is_directory(input, error)) {
+            std::vector<std::string> found;
+            for (const auto& item : std::filesystem::directory_iterator(input, error)) {
+                if (item.path().extension() == ".lvl") found.push_back(item.path().string());
+            }
+            std::sort(found.begin(), found.end());
+            files.insert(files.end(), found.begin(), found.end());
+        }
+        else {
+            files.push_back(input);
+        }
+    }
+
+    std::vector<Level> levels(files.size());
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (!ParseLevelFile(files[i], levels[i])) return 1;
+    }
+    if (levels.empty()) {
+        fprintf(stderr, "pack: no levels given\n");
+        return 1;
+    }
+
+    std::sort(levels.begin(), levels.end(), [](const Level& a, const Level& b) { return a.id < b.id; });
+    for (size_t i = 1; i < levels.size(); ++i) {
+        if (levels[i].id == levels[i - 1].id) {
+            fprintf(stderr, "pack: level id %u is used twice\n", levels[i].id);
+            return 1;
+        }
+    }
+
+    ByteWriter writer;
+    writer.U32(LEVEL_PACK_MAGIC);
+    writer.U16(LEVEL_PACK_VERSION);
+    writer.U16(0);
+    writer.U32((uint32_t)levels.size());
+    writer.U32(0);
+
+    std::vector<LevelPackEntry> entries(levels.size());
+    for (size_t i = 0; i < levels.size(); ++i) {
+        LevelPackEntry& entry = entries[i];
+        entry.id = levels[i].id;
+        entry.name = levels[i].name;
+
+        std::vector<uint8_t> raw = EncodeLevel(levels[i]);
+        entry.rawSize = (uint32_t)raw.size();
+        entry.checksum = LevelChecksum(raw.data(), raw.size());
+        AppendCompressed(writer, raw.data(), raw.size(), entry.dataOffset, entry.dataSize);
+
+        Image thumbnail = RenderThumbnail(levels[i]);
+        AppendCompressed(writer, thumbnail.data, (size_t)THUMBNAIL_WIDTH * THUMBNAIL_HEIGHT * 4, entry.thumbnailOffset, entry.thumbnailSize);
+        UnloadImage(thumbnail);
+    }
+
+    uint32_t indexOffset = (uint32_t)writer.bytes.size();
+    for (const auto& entry : entries) WriteLevelPackEntry(writer, entry);
+    for (int i = 0; i < 4; ++i) writer.bytes[12 + i] = (uint8_t)(indexOffset >> (8 * i));
+
+    if (!SaveFileData(outPath.c_str(), writer.bytes.data(), (int)writer.bytes.size())) {
+        fprintf(stderr, "pack: cannot write %s\n", outPath.c_str());
+        return 1;
+    }
+    printf("pack: %zu levels, %zu KB written to %s\n", levels.size(), writer.bytes.size() / 1024, outPath.c_str());
+    return 0;
+}
+
+// Writes every level of the active catalog as .lvl source.
+int RunExportLevels(const std::string& dir) {
+    std::error_code error;
+    std::filesystem::create_directories(dir, error);
+
+    const LevelCatalog& catalog = ActiveCatalog();
+    for (size_t i = 0; i < catalog.Count(); ++i) {
+        Level level;
+        std::string path = (std::filesystem::path(dir) / TextFormat("level_%04u.lvl", catalog.IdAt(i))).string();
+        if (!catalog.Load(i, level) || !WriteLevelFile(path, level)) {
+            fprintf(stderr, "export: cannot write %s\n", path.c_str());
+            return 1;
+        }
+    }
+    printf("export: %zu levels written to %s\n", catalog.Count(), dir.c_str());
+    return 0;
+}
+
+struct LaunchOptions {
+    bool versus = false;
+    uint16_t localPort = 0;
+    std::string remoteHost = "127.0.0.1";
+    uint16_t remotePort = 0;
+    uint32_t level = 1;
+
+    bool validateServer = false;
+    std::string validateReplay;
+    std::string viewReplay;
+    uint16_t validatePort = VALIDATION_DEFAULT_PORT;
+    int workers = 0;
+    double validateCpuLimitMs = 50.0;
+    int validateRepeat = 1;
+
+    uint16_t spectatorPort = 0;
+    std::string spectateHost;
+    uint16_t spectatePort = 0;
+
+    std::vector<std::string> shotReportFiles;
+
+    bool difficulty = false;
+    int difficultyGames = 20000;
+    HumanErrorModel errorModel;
+    double parRate = 0.5;
+
+    std::string packPath;
+    std::string packLevelsOut;
+    std::vector<std::string> packLevelsInputs;
+    std::string exportLevelsDir;
+
+    double hitchBudgetMs = 20.0;
+    double textureBudgetMb = 0;
+    bool idle = true;
+    std::string watchDir;
+
+    bool benchmark = false;
+    std::string benchmarkOut = "benchmark.json";
+
+    bool farm = false;
+    std::string farmOut = "telemetry/farm.shotlog";
+    std::string farmWorkerName;
+    int farmWorkerSlot = -1;
+    int farmWorkerCore = -1;
+};
+
+// AngryBirds --versus <localPort> <remoteHost> <remotePort> [level]
+// AngryBirds --validate-server [--port N] [--workers N] [--cpu-limit-ms N]
+// AngryBirds --validate <replay> [--port N] [--repeat N]
+// AngryBirds --replay <replay>
+// AngryBirds --spectator-port <port>
+// AngryBirds --spectate <host> <port>
+// AngryBirds --shot-report <file.shotlog>...
+// AngryBirds --difficulty [--games N] [--aim-sigma DEG] [--power-sigma F] [--par-rate F] [--workers N]
+// AngryBirds --pack-levels <out.abpk> <file.lvl|dir>...
+// AngryBirds --export-levels <dir>
+// AngryBirds --benchmark [out.json]
+// AngryBirds --farm [out.shotlog] [--workers N]
+// Any mode also takes --pack <file.abpk> to play from a level pack.
+// A normal launch takes --hitch-budget-ms N (0 disables hitch dumps) and
+// --texture-budget-mb N (0, the default, never evicts), --no-idle to keep
+// redrawing at full rate when nothing changes, and --watch <dir> to apply
+// edits to the .lvl file of the level being played as it is saved.
+LaunchOptions ParseLaunchOptions(int argc, char** argv) {
+    LaunchOptions options;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--spectator-port") == 0 && i + 1 < argc) {
+            options.spectatorPort = (uint16_t)atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--spectate") == 0 && i + 2 < argc) {
+            options.spectateHost = argv[i + 1];
+            options.spectatePort = (uint16_t)atoi(argv[i + 2]);
+            i += 2;
+        }
+        else if (strcmp(argv[i], "--shot-report") == 0) {
+            while (i + 1 < argc && argv[i + 1][0] != '-') {
+                options.shotReportFiles.push_back(argv[++i]);
+            }
+        }
+        else if (strcmp(argv[i], "--pack") == 0 && i + 1 < argc) {
+            options.packPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--pack-levels") == 0 && i + 1 < argc) {
+            options.packLevelsOut = argv[++i];
+            while (i + 1 < argc && argv[i + 1][0] != '-') {
+                options.packLevelsInputs.push_back(argv[++i]);
+            }
+        }
+        else if (strcmp(argv[i], "--export-levels") == 0 && i + 1 < argc) {
+            options.exportLevelsDir = argv[++i];
+        }
+        else if (strcmp(argv[i], "--hitch-budget-ms") == 0 && i + 1 < argc) {
+            options.hitchBudgetMs = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--texture-budget-mb") == 0 && i + 1 < argc) {
+            options.textureBudgetMb = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--no-idle") == 0) {
+            options.idle = false;
+        }
+        else if (strcmp(argv[i], "--watch") == 0 && i + 1 < argc) {
+            options.watchDir = argv[++i];
+        }
+        else if (strcmp(argv[i], "--benchmark") == 0) {
+            options.benchmark = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                options.benchmarkOut = argv[++i];
+            }
+        }
+        else if (strcmp(argv[i], "--farm") == 0) {
+            options.farm = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                options.farmOut = argv[++i];
+            }
+        }
+        else if (strcmp(argv[i], "--farm-worker") == 0 && i + 3 < argc) {
+            options.farmWorkerName = argv[i + 1];
+            options.farmWorkerSlot = atoi(argv[i + 2]);
+            options.farmWorkerCore = atoi(argv[i + 3]);
+            i += 3;
+        }
+        else if (strcmp(argv[i], "--difficulty") == 0) {
+            options.difficulty = true;
+        }
+        else if (strcmp(argv[i], "--games") == 0 && i + 1 < argc) {
+            options.difficultyGames = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--aim-sigma") == 0 && i + 1 < argc) {
+            options.errorModel.aimSigmaDegrees = (float)atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--power-sigma") == 0 && i + 1 < argc) {
+            options.errorModel.powerSigma = (float)atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--par-rate") == 0 && i + 1 < argc) {
+            options.parRate = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--validate-server") == 0) {
+            options.validateServer = true;
+        }
+        else if (strcmp(argv[i], "--validate") == 0 && i + 1 < argc) {
+            options.validateReplay = argv[++i];
+        }
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            options.viewReplay = argv[++i];
+        }
+        else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            options.validatePort = (uint16_t)atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            options.workers = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--cpu-limit-ms") == 0 && i + 1 < argc) {
+            options.validateCpuLimitMs = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            options.validateRepeat = atoi(argv[++i]);
+        }
 
-            int dx = xStart - ball.pos.x;
-            int dy = yStart - ball.pos.y;
+        else if (strcmp(argv[i], "--versus") == 0 && i + 3 < argc) {
+            options.versus = true;
+            options.localPort = (uint16_t)atoi(argv[i + 1]);
+            options.remoteHost = argv[i + 2];
+            options.remotePort = (uint16_t)atoi(argv[i + 3]);
+            i += 3;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                options.level = (uint32_t)strtoul(argv[++i], nullptr, 10);
+            }
+        }
+    }
 
-            launchDistance = std::sqrt(dx * dx + dy * dy);
-            relativeAngle = atan2(dy, dx) + PI;
-            launchAngle = PI - relativeAngle;
+    return options;
+}
 
-            if (launchDistance > LAUNCH_MAX_DISTANCE) {
-                ball.pos.x = xStart + std::cos(relativeAngle) * LAUNCH_MAX_DISTANCE;
-                ball.pos.y = yStart + std::sin(relativeAngle) * LAUNCH_MAX_DISTANCE;
-            }
+// Paginated level select. Only the visible page has its thumbnails
+// decompressed and uploaded; turning the page releases them.
+class LevelSelectScreen {
+private:
+    static constexpr int COLUMNS = 4;
+    static constexpr int ROWS = 2;
+    static constexpr int CARDS_PER_PAGE = COLUMNS * ROWS;
+    static constexpr float CARD_WIDTH = THUMBNAIL_WIDTH + 24.0f;
+    static constexpr float CARD_HEIGHT = THUMBNAIL_HEIGHT + 64.0f;
+    static constexpr float CARD_SPACING = 30.0f;
+    static constexpr float CARDS_TOP = 190.0f;
+
+    const LevelCatalog& catalog;
+    int page = 0;
+    int loadedPage = -1;
+    int pressedCard = -1;
+    std::vector<Texture2D> thumbnails;
+    Rectangle previousButton = { WORLD_WIDTH / 2 - 160, CARDS_TOP + ROWS * (CARD_HEIGHT + CARD_SPACING), 60, 40 };
+    Rectangle nextButton = { WORLD_WIDTH / 2 + 100, CARDS_TOP + ROWS * (CARD_HEIGHT + CARD_SPACING), 60, 40 };
+
+    int PageCount() const {
+        return std::max(1, (int)((catalog.Count() + CARDS_PER_PAGE - 1) / CARDS_PER_PAGE));
+    }
 
-            float vx = std::abs(ball.pos.x - xStart) / LAUNCH_MAX_DISTANCE;
-            float vy = -std::abs(ball.pos.y - yStart) / LAUNCH_MAX_DISTANCE;
+    int CardsOnPage() const {
+        return (int)std::min<size_t>(CARDS_PER_PAGE, catalog.Count() - (size_t)page * CARDS_PER_PAGE);
+    }
 
-            ball.vel.x = vx * std::cos(launchAngle) * VELOCITY_MULTIPLIER;
-            ball.vel.y = vy * std::sin(launchAngle) * VELOCITY_MULTIPLIER;
-        }
+    Rectangle CardRect(int card) const {
+        float startX = (WORLD_WIDTH - (COLUMNS * CARD_WIDTH + (COLUMNS - 1) * CARD_SPACING)) / 2.0f;
+        return { startX + (card % COLUMNS) * (CARD_WIDTH + CARD_SPACING),
+            CARDS_TOP + (card / COLUMNS) * (CARD_HEIGHT + CARD_SPACING), CARD_WIDTH, CARD_HEIGHT };
+    }
 
-        if (IsMouseButtonReleased(MOUSE_BUTTON_LEFT)) {
-            if (selectedBall && (ball.pos.x != xStart || ball.pos.y != yStart)) {
-                launched = true;
-                attempts--;
-                powerupActive = false;
-            }
-            selectedBall = nullptr;
+    void LoadPage() {
+        Unload();
+        for (int card = 0; card < CardsOnPage(); ++card) {
+            Image image = catalog.LoadThumbnail((size_t)page * CARDS_PER_PAGE + card);
+            thumbnails.push_back(LoadTextureFromImage(image));
+            UnloadImage(image);
         }
+        loadedPage = page;
+    }
 
-        if (launched) {
-  
-            if (ball.isActive) {
-                UpdateBall(ball);
-            }
+    void TurnPage(int delta) {
+        page = std::max(0, std::min(PageCount() - 1, page + delta));
+        pressedCard = -1;
+    }
 
-  
-            for (auto& splitBall : splitBalls) {
-                if (splitBall.isActive) {
-                    UpdateBall(splitBall);
-                }
-            }
+public:
+    explicit LevelSelectScreen(const LevelCatalog& levels) : catalog(levels) {}
 
- 
-            bool allBallsStopped = !ball.isActive;
-            for (const auto& splitBall : splitBalls) {
-                if (splitBall.isActive) {
-                    allBallsStopped = false;
-                    break;
-                }
-            }
+    ~LevelSelectScreen() {
+        Unload();
+    }
 
-            if (allBallsStopped) {
-          
-                if (attempts <= 0) {
-               
-                    if (currentLevel->state != LevelState::COMPLETED) {
-                        currentLevel->state = LevelState::FAILED;
-                    }
-                }
+    void Unload() {
+        for (const auto& texture : thumbnails) UnloadTexture(texture);
+        thumbnails.clear();
+        loadedPage = -1;
+    }
 
-            
-                ResetBalls();
-            }
+    // Returns the id of the level whose card was clicked, or 0.
+    uint32_t Update(Vector2 mousePos) {
+        if (IsKeyPressed(KEY_LEFT) || (IsMouseButtonPressed(MOUSE_BUTTON_LEFT) && CheckCollisionPointRec(mousePos, previousButton))) {
+            TurnPage(-1);
         }
-
-        if (IsMouseButtonPressed(MOUSE_BUTTON_RIGHT) || IsKeyPressed(KEY_SPACE)) {
-            Reset();
-            currentLevel->Reset();
-            attempts = 3;
+        if (IsKeyPressed(KEY_RIGHT) || (IsMouseButtonPressed(MOUSE_BUTTON_LEFT) && CheckCollisionPointRec(mousePos, nextButton))) {
+            TurnPage(1);
         }
 
-
-        if (IsKeyPressed(KEY_ONE)) {
-            SetLevel(1);
+        int hovered = -1;
+        for (int card = 0; card < CardsOnPage(); ++card) {
+            if (CheckCollisionPointRec(mousePos, CardRect(card))) hovered = card;
         }
-        else if (IsKeyPressed(KEY_TWO)) {
-            SetLevel(2);
-        }
-        else if (IsKeyPressed(KEY_THREE)) {
-            SetLevel(3);
+
+        if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
+            pressedCard = hovered;
         }
-        else if (IsKeyPressed(KEY_FOUR)) {
-            SetLevel(4);
+        if (IsMouseButtonReleased(MOUSE_BUTTON_LEFT)) {
+            bool clicked = hovered != -1 && hovered == pressedCard;
+            pressedCard = -1;
+            if (clicked) return catalog.IdAt((size_t)page * CARDS_PER_PAGE + hovered);
         }
+        return 0;
     }
 
-    void UpdateBall(Ball& currentBall) {
-        bool hitAny = false;
-
-        for (auto& obs : currentLevel->obstacles) {
-            if (currentBall.CollidesWith(obs)) {
-                if (obs.visible) {
-                    hitAny = true;
-                    obs.visible = false;
-                    currentBall.vel.x *= currentBall.elasticity;
-                }
+    void Draw(const GameWorld& game) {
+        if (loadedPage != page) LoadPage();
+
+        for (int card = 0; card < CardsOnPage(); ++card) {
+            size_t index = (size_t)page * CARDS_PER_PAGE + card;
+            uint32_t id = catalog.IdAt(index);
+            Rectangle rect = CardRect(card);
+
+            DrawRectangleRec(rect, { 255, 255, 255, 210 });
+            DrawRectangleLinesEx(rect, 2, card == pressedCard ? ORANGE : DARKGRAY);
+            DrawTexture(thumbnails[card], (int)rect.x + 12, (int)rect.y + 12, WHITE);
+            drawSubmissions += 3;
+            DrawText(TextFormat("%u. %.20s", id, catalog.NameAt(index).c_str()),
+                (int)rect.x + 12, (int)rect.y + THUMBNAIL_HEIGHT + 18, 16, BLACK);
+
+            auto score = game.levelScores.find(id);
+            if (game.currentLevel.id == id) {
+                DrawText(TextFormat("Score: %d", game.currentLevel.GetCurrentScore()),
+                    (int)rect.x + 12, (int)rect.y + THUMBNAIL_HEIGHT + 40, 16, DARKGREEN);
+            }
+            else if (score != game.levelScores.end()) {
+                DrawText(TextFormat("Score: %d", score->second), (int)rect.x + 12, (int)rect.y + THUMBNAIL_HEIGHT + 40, 16, DARKGREEN);
             }
         }
 
-        if (hitAny) {
-        
-            currentLevel->Update();
-        }
+        DrawRectangleRec(previousButton, page > 0 ? DARKBLUE : GRAY);
+        DrawText("<", (int)previousButton.x + 22, (int)previousButton.y + 8, 28, WHITE);
+        DrawRectangleRec(nextButton, page + 1 < PageCount() ? DARKBLUE : GRAY);
+        DrawText(">", (int)nextButton.x + 22, (int)nextButton.y + 8, 28, WHITE);
 
-        if (currentBall.pos.y + currentBall.radius > GetScreenHeight()) {
-            currentBall.pos.y = GetScreenHeight() - currentBall.radius;
-            currentBall.vel.y *= -currentBall.elasticity;
-        }
+        const char* pageText = TextFormat("Page %d / %d", page + 1, PageCount());
+        DrawText(pageText, (int)(WORLD_WIDTH - MeasureText(pageText, 20)) / 2, (int)previousButton.y + 10, 20, BLACK);
+    }
+};
 
-        currentBall.pos.x += currentBall.vel.x;
-        currentBall.pos.y += currentBall.vel.y;
-        currentBall.vel.y += GRAVITY;
+constexpr double IDLE_AFTER_SECONDS = 1.0;
+constexpr double IDLE_POLL_SECONDS = 0.1;
 
-        currentBall.rotationAngle += 5;
-        currentBall.vel.x *= currentBall.friction;
-        currentBall.vel.y *= currentBall.friction;
+// Stops redrawing while nothing on screen can change. After a second with
+// no input and nothing animating, raylib is switched to block on input
+// events inside EndDrawing instead of polling; the first event wakes the
+// loop, which sees the input and switches back before it presents again.
+// When something other than input can need the loop (a spectator joining),
+// it sleeps IDLE_POLL_SECONDS per frame instead of blocking.
+class IdleMode {
+private:
+    bool enabled;
+    bool waiting = false;
+    bool polling = false;
+    double quietSince = 0;
+
+    static bool InputThisFrame() {
+        Vector2 delta = GetMouseDelta();
+        if (delta.x != 0 || delta.y != 0 || GetMouseWheelMove() != 0) return true;
+        for (int button = MOUSE_BUTTON_LEFT; button <= MOUSE_BUTTON_MIDDLE; ++button) {
+            if (IsMouseButtonDown(button) || IsMouseButtonReleased(button)) return true;
+        }
+        return GetKeyPressed() != 0;
+    }
 
-      
-        if (fabs(currentBall.vel.x) < 0.1f && fabs(currentBall.vel.y) < 0.1f &&
-            currentBall.pos.y > GetScreenHeight() - currentBall.radius - 1) {
-            currentBall.isActive = false;
+public:
+    explicit IdleMode(bool enable) : enabled(enable) {}
+
+    // Call once per frame before EndDrawing.
+    void Update(bool busy, bool poll) {
+        double now = GetTime();
+        if (!enabled || busy || InputThisFrame()) {
+            quietSince = now;
+            if (waiting && !polling) DisableEventWaiting();
+            waiting = false;
+        }
+        else if (!waiting && now - quietSince >= IDLE_AFTER_SECONDS) {
+            polling = poll;
+            if (!polling) EnableEventWaiting();
+            waiting = true;
         }
     }
 
-    void ActivateSplitPowerup() {
-        if (!canUsePowerup || !launched || ball.isSplit || splitBalls.size() > 0) return;
+    // Call at the top of the loop; sleeps out the poll interval while idle.
+    void Sleep() const {
+        if (waiting && polling) WaitTime(IDLE_POLL_SECONDS);
+    }
 
-     
-        totalScore -= powerupCost;
-        powerupActive = true;
+    // Whether this frame is an idle one: EndDrawing blocks until the next
+    // event, or the loop sleeps before the next frame.
+    bool Waiting() const {
+        return waiting;
+    }
+};
 
-      
-        splitBalls.push_back(ball.CreateSplitBall(-30.0f));
-        splitBalls.push_back(ball.CreateSplitBall(30.0f));
+// raylib's stream callback carries no user pointer.
+ImpactMixer* activeMixer = nullptr;
 
-       
-        ball.isSplit = true;
-        ball.radius *= 0.7f;
+// Runs on the audio device thread.
+void MixImpactAudio(void* buffer, unsigned int frames) {
+    activeMixer->Mix(static_cast<int16_t*>(buffer), frames);
+}
+
+enum GameState {
+    MENU,
+    PLAYING,
+    LEVEL_SELECT, 
+    EXIT_GAME
+};
+
+constexpr int BENCHMARK_WARMUP_FRAMES = 10;
+constexpr int BENCHMARK_MENU_FRAMES = 3 * TICKS_PER_SECOND;
+constexpr int BENCHMARK_LEVEL_FRAMES = 8 * TICKS_PER_SECOND;
+constexpr int BENCHMARK_COLLAPSE_FRAMES = 12 * TICKS_PER_SECOND;
+constexpr int BENCHMARK_COLLAPSE_BLOCKS = 10000;
+constexpr int BENCHMARK_PULL_FRAMES = 15;
+constexpr int BENCHMARK_SHOT_DELAY_FRAMES = TICKS_PER_SECOND / 2;
+constexpr float BENCHMARK_SHOT_AIM_DEGREES = 25.0f;
+
+// A wall of small blocks in front of the slingshot for the demolition
+// scene, with heavy and explosive birds to bring it down.
+Level BuildCollapseLevel(int blocks) {
+    constexpr int COLUMNS = 100;
+    constexpr float PITCH_X = 6.0f;
+    constexpr float PITCH_Y = 5.0f;
+    int rows = (blocks + COLUMNS - 1) / COLUMNS;
+    float left = WORLD_WIDTH - 40.0f - COLUMNS * PITCH_X;
+    float top = GROUND_Y - rows * PITCH_Y;
+
+    Level level;
+    level.name = "Benchmark collapse";
+    level.targetScore = DIFFICULTY_UNREACHABLE_TARGET;
+    level.birds = { BirdType::HEAVY, BirdType::EXPLOSIVE, BirdType::EXPLOSIVE };
+    level.obstacles.reserve(blocks);
+    for (int i = 0; i < blocks; ++i) {
+        int row = i / COLUMNS, column = i % COLUMNS;
+        Color fill = (row + column) % 2 == 0 ? BROWN : DARKBROWN;
+        level.obstacles.push_back(Obstacle({ left + column * PITCH_X, top + row * PITCH_Y, PITCH_X - 1, PITCH_Y - 1 }, true, fill, DARKBROWN));
     }
+    return level;
+}
 
-    void Reset() {
-        ResetBalls();
-        splitBalls.clear();
-        powerupActive = false;
+// Scripted --benchmark run through the real window, update and draw path:
+// the menu, level select, every built-in level with a canned shot and a
+// 10k-block demolition. Frame time, draw submissions and simulation tick
+// cost are collected per scene and written out as JSON.
+class BenchmarkRun {
+private:
+    struct Scene {
+        std::string name;
+        GameState state = MENU;
+        // Catalog level to play; 0 with shots > 0 is the generated collapse.
+        uint32_t level = 0;
+        int shots = 0;
+        int frames = 0;
+
+        std::vector<float> frameMs;
+        std::vector<float> tickMs;
+        std::vector<float> pairTests;
+        std::vector<uint32_t> draws;
+        size_t blocks = 0;
+        int destroyed = 0;
+    };
+
+    struct Summary {
+        double mean = 0, p50 = 0, p90 = 0, p99 = 0, max = 0;
+    };
+
+    std::vector<Scene> scenes;
+    size_t current = 0;
+    int frame = 0;
+    int64_t frameStart = 0;
+    int shotsFired = 0;
+    int shotFrame = -1;
+    int nextShotFrame = 0;
+
+    static Summary Summarize(std::vector<float> samples) {
+        Summary summary;
+        if (samples.empty()) return summary;
+
+        std::sort(samples.begin(), samples.end());
+        auto at = [&](double p) { return (double)samples[(size_t)std::lround(p * (samples.size() - 1))]; };
+        double sum = 0;
+        for (float sample : samples) sum += sample;
+        summary.mean = sum / samples.size();
+        summary.p50 = at(0.5);
+        summary.p90 = at(0.9);
+        summary.p99 = at(0.99);
+        summary.max = samples.back();
+        return summary;
     }
 
-    void ResetBalls() {
-        ball.pos = { xStart, yStart };
-        ball.vel = { 50, -50 };
-        ball.rotationAngle = 0;
-        ball.isSplit = false;
-        ball.isActive = true;
-        ball.radius = 40;
-        launched = false;
-        selectedBall = nullptr;
-        splitBalls.clear();
+    static void WriteSummary(FILE* file, const char* name, const Summary& summary) {
+        fprintf(file, "\"%s\":{\"mean\":%.3f,\"p50\":%.3f,\"p90\":%.3f,\"p99\":%.3f,\"max\":%.3f}",
+            name, summary.mean, summary.p50, summary.p90, summary.p99, summary.max);
     }
 
-    void Draw() {
-     
-        if (levelBackgroundTexture.id > 0) {
-            DrawTexturePro(levelBackgroundTexture,
-                { 0.0f, 0.0f, (float)levelBackgroundTexture.width, (float)levelBackgroundTexture.height },
-                { 0.0f, 0.0f, (float)GetScreenWidth(), (float)GetScreenHeight() },
-                { 0, 0 },
-                0.0f,
-                WHITE);
-        }
-        else {
-            ClearBackground(DARKGRAY);
-            DrawText("Failed to load background texture!", 10, GetScreenHeight() / 2, 20, RED);
+    void AddScene(const std::string& name, GameState state, uint32_t level, int shots, int frames) {
+        Scene scene;
+        scene.name = name;
+        scene.state = state;
+        scene.level = level;
+        scene.shots = shots;
+        scene.frames = frames;
+        scenes.push_back(scene);
+    }
+
+    void Enter(GameWorld& game) {
+        Scene& scene = scenes[current];
+        frame = 0;
+        shotsFired = 0;
+        shotFrame = -1;
+        nextShotFrame = BENCHMARK_SHOT_DELAY_FRAMES;
+        if (scene.state != PLAYING) return;
+
+        // Uncapped so a good shot does not move the scene on to the next level.
+        if (!game.initialized) game.Init();
+        SelectUncappedLevel(game, scene.level != 0 ? scene.level : BUILTIN_LEVELS[0].id);
+        if (scene.level == 0) {
+            game.currentLevel = BuildCollapseLevel(BENCHMARK_COLLAPSE_BLOCKS);
+            game.LoadNextBird();
         }
+        scene.blocks = game.currentLevel.obstacles.size();
+    }
 
-       
-        DrawRectangle(xStart - 10, yStart - ball.radius - 10, 20, ball.radius * 2 + 130, { 100, 100, 100, 200 });
+    // Press on the bird, drag it back over a few frames, then let go.
+    InputFrame ScriptedShot(const GameWorld& game) {
+        InputFrame input;
+        if (shotFrame < 0) {
+            bool ready = !game.launched && game.ball.isActive && game.currentLevel.state == LevelState::PLAYING;
+            if (shotsFired >= scenes[current].shots || !ready || frame < nextShotFrame) return input;
+            shotFrame = 0;
+        }
 
-       
-        for (const auto& obs : currentLevel->obstacles) obs.Draw();
+        float aim = toRadians(BENCHMARK_SHOT_AIM_DEGREES);
+        float distance = LAUNCH_MAX_DISTANCE * std::min(1.0f, (float)shotFrame / BENCHMARK_PULL_FRAMES);
+        input.mouseX = (int16_t)std::lround(game.xStart - std::cos(aim) * distance);
+        input.mouseY = (int16_t)std::lround(game.yStart + std::sin(aim) * distance);
 
-        
-        for (const auto& splitBall : splitBalls) {
-            if (splitBall.isActive) {
-                splitBall.Draw(launched, nullptr, xStart, yStart);
-            }
+        if (shotFrame == 0) {
+            input.flags = INPUT_PRESS | INPUT_HOLD;
         }
+        else if (shotFrame <= BENCHMARK_PULL_FRAMES) {
+            input.flags = INPUT_HOLD;
+        }
+        else {
+            input.flags = INPUT_RELEASE;
+            shotsFired++;
+            shotFrame = -1;
+            nextShotFrame = frame + BENCHMARK_SHOT_DELAY_FRAMES;
+            return input;
+        }
+        shotFrame++;
+        return input;
+    }
 
-      
-        if (ball.isActive) {
-            ball.Draw(launched, selectedBall, xStart, yStart);
+public:
+    void Start(GameWorld& game) {
+        scenes.clear();
+        AddScene("menu", MENU, 0, 0, BENCHMARK_MENU_FRAMES);
+        AddScene("level_select", LEVEL_SELECT, 0, 0, BENCHMARK_MENU_FRAMES);
+        for (const BuiltinLevel& builtin : BUILTIN_LEVELS) {
+            AddScene("level_" + std::to_string(builtin.id), PLAYING, builtin.id, 1, BENCHMARK_LEVEL_FRAMES);
         }
+        AddScene("collapse_10k", PLAYING, 0, BIRDS_PER_LEVEL, BENCHMARK_COLLAPSE_FRAMES);
 
-       
-        DrawRectangle(0, 0, GetScreenWidth(), 50, { 0, 0, 0, 120 });
+        current = 0;
+        Enter(game);
+    }
 
-        
-        DrawText(TextFormat("Level %d: %s", currentLevelIndex, currentLevel->name.c_str()), 10, 10, 20, WHITE);
-        DrawText(TextFormat("Score: %d/%d", currentLevel->GetCurrentScore(), currentLevel->targetScore), 400, 10, 20, WHITE);
-        DrawText(TextFormat("Total Score: %d", totalScore), 600, 10, 20, WHITE);
-        DrawText(TextFormat("Attempts: %d", attempts), 800, 10, 20, WHITE);
+    bool Running() const {
+        return current < scenes.size();
+    }
 
-      
-        if (powerupButtonTexture.id > 0) {
-            DrawTexturePro(powerupButtonTexture,
-                { 0.0f, 0.0f, (float)powerupButtonTexture.width, (float)powerupButtonTexture.height },
-                powerupButton,
-                { 0, 0 },
-                0.0f,
-                canUsePowerup && launched && !powerupActive && !ball.isSplit ? WHITE : GRAY);
-        }
-        else {
-            DrawRectangleRec(powerupButton, canUsePowerup && launched && !powerupActive && !ball.isSplit ? BLUE : DARKGRAY);
-            DrawRectangleLinesEx(powerupButton, 2, BLACK);
-            DrawText("SPLIT", powerupButton.x + 10, powerupButton.y + 10, 20, WHITE);
-        }
-        DrawText(TextFormat("Cost: %d", powerupCost), powerupButton.x, powerupButton.y + powerupButton.height + 5, 16, WHITE);
+    // Called at the top of a frame. Returns the state to show and, while
+    // playing, the input to step with.
+    GameState BeginFrame(const GameWorld& game, InputFrame& input) {
+        frameStart = Recorder().Now();
+        input = InputFrame();
+        if (scenes[current].state == PLAYING) input = ScriptedShot(game);
+        return scenes[current].state;
+    }
 
-     
-        if (currentLevel->state == LevelState::COMPLETED) {
-            const char* message = "LEVEL COMPLETED!";
-            int fontSize = 40;
-            int textWidth = MeasureText(message, fontSize);
-            DrawRectangle((GetScreenWidth() - textWidth) / 2 - 10, GetScreenHeight() / 2 - 30, textWidth + 20, 60, { 0, 0, 0, 200 });
-            DrawText(message, (GetScreenWidth() - textWidth) / 2, GetScreenHeight() / 2 - 20, fontSize, GREEN);
+    void RecordTick(int64_t nanoseconds, uint32_t pairTests) {
+        if (frame < BENCHMARK_WARMUP_FRAMES) return;
+        scenes[current].tickMs.push_back(nanoseconds / 1e6f);
+        scenes[current].pairTests.push_back((float)pairTests);
+    }
 
-            if (currentLevelIndex < 4) {
-                const char* nextMessage = "Next level loading...";
-                int nextFontSize = 20;
-                int nextTextWidth = MeasureText(nextMessage, nextFontSize);
-                DrawText(nextMessage, (GetScreenWidth() - nextTextWidth) / 2, GetScreenHeight() / 2 + 30, nextFontSize, WHITE);
-            }
-            else {
-                const char* finalMessage = "Congratulations! You completed all levels!";
-                int finalFontSize = 20;
-                int finalTextWidth = MeasureText(finalMessage, finalFontSize);
-                DrawText(finalMessage, (GetScreenWidth() - finalTextWidth) / 2, GetScreenHeight() / 2 + 30, finalFontSize, WHITE);
-            }
+    // Called after the frame is presented.
+    void EndFrame(GameWorld& game) {
+        Scene& scene = scenes[current];
+        if (frame >= BENCHMARK_WARMUP_FRAMES) {
+            scene.frameMs.push_back((Recorder().Now() - frameStart) / 1e6f);
+            scene.draws.push_back(drawSubmissions);
         }
-        else if (currentLevel->state == LevelState::FAILED && attempts <= 0) {
-            const char* message = "NO ATTEMPTS LEFT!";
-            int fontSize = 40;
-            int textWidth = MeasureText(message, fontSize);
-            DrawRectangle((GetScreenWidth() - textWidth) / 2 - 10, GetScreenHeight() / 2 - 30, textWidth + 20, 60, { 0, 0, 0, 200 });
-            DrawText(message, (GetScreenWidth() - textWidth) / 2, GetScreenHeight() / 2 - 20, fontSize, RED);
 
-            const char* retryMessage = "Press SPACE to retry";
-            int retryFontSize = 20;
-            int retryTextWidth = MeasureText(retryMessage, retryFontSize);
-            DrawText(retryMessage, (GetScreenWidth() - retryTextWidth) / 2, GetScreenHeight() / 2 + 30, retryFontSize, WHITE);
-        }
+        if (++frame < scene.frames) return;
 
-        
-        DrawText("Controls: 1,2,3,4 - Select Level | SPACE - Reset | ESC - Menu", 10, GetScreenHeight() - 30, 20, WHITE);
-        DrawText("Left click during flight to activate power-up!", 10, GetScreenHeight() - 60, 20, YELLOW);
+        if (scene.state == PLAYING) scene.destroyed = game.currentLevel.GetCurrentScore() / 10;
+        printf("benchmark: %-14s %4zu frames, p50 %.2f ms, p99 %.2f ms\n", scene.name.c_str(), scene.frameMs.size(),
+            Summarize(scene.frameMs).p50, Summarize(scene.frameMs).p99);
+        if (++current < scenes.size()) Enter(game);
     }
-};
 
-enum GameState {
-    MENU,
-    PLAYING,
-    LEVEL_SELECT, 
-    EXIT_GAME
+    bool WriteReport(const std::string& path) const {
+        FILE* file = fopen(path.c_str(), "w");
+        if (file == nullptr) return false;
+
+        fprintf(file, "{\"renderWidth\":%d,\"renderHeight\":%d,\"warmupFrames\":%d,\"scenes\":[\n",
+            GetRenderWidth(), GetRenderHeight(), BENCHMARK_WARMUP_FRAMES);
+        for (size_t i = 0; i < scenes.size(); ++i) {
+            const Scene& scene = scenes[i];
+            std::vector<float> draws(scene.draws.begin(), scene.draws.end());
+
+            fprintf(file, "{\"name\":\"%s\",\"frames\":%zu,\"ticks\":%zu,\"blocks\":%zu,\"destroyed\":%d,",
+                scene.name.c_str(), scene.frameMs.size(), scene.tickMs.size(), scene.blocks, scene.destroyed);
+            WriteSummary(file, "frameMs", Summarize(scene.frameMs));
+            fprintf(file, ",");
+            WriteSummary(file, "tickMs", Summarize(scene.tickMs));
+            fprintf(file, ",");
+            WriteSummary(file, "pairTests", Summarize(scene.pairTests));
+            fprintf(file, ",");
+            WriteSummary(file, "draws", Summarize(draws));
+            fprintf(file, "}%s\n", i + 1 < scenes.size() ? "," : "");
+        }
+        fprintf(file, "]}\n");
+        return fclose(file) == 0;
+    }
 };
 
-int main()
+int main(int argc, char** argv)
 {
-    const int screenWidth = 1280;
-    const int screenHeight = 720;
+    const int screenWidth = (int)WORLD_WIDTH;
+    const int screenHeight = (int)WORLD_HEIGHT;
+
+    LaunchOptions options = ParseLaunchOptions(argc, argv);
+
+    if (!options.packLevelsOut.empty()) {
+        return RunPackLevels(options.packLevelsOut, options.packLevelsInputs);
+    }
+    if (options.benchmark && !options.packPath.empty()) {
+        fprintf(stderr, "--benchmark plays the built-in levels and does not take --pack\n");
+        return 1;
+    }
+    if (!options.packPath.empty() && !ActiveCatalog().OpenPack(options.packPath)) {
+        return 1;
+    }
+    if (!options.exportLevelsDir.empty()) {
+        return RunExportLevels(options.exportLevelsDir);
+    }
+    if (options.validateServer) {
+        int workers = options.workers > 0 ? options.workers : (int)std::thread::hardware_concurrency();
+        ReplayValidationService service;
+        return service.Run(options.validatePort, workers > 0 ? workers : 1, options.validateCpuLimitMs / 1000.0);
+    }
+    if (!options.validateReplay.empty()) {
+        return RunValidationClient(options.validateReplay.c_str(), "127.0.0.1", options.validatePort, options.validateRepeat);
+    }
+    if (!options.shotReportFiles.empty()) {
+        return RunShotReport(options.shotReportFiles);
+    }
+    if (options.difficulty) {
+        int workers = options.workers > 0 ? options.workers : (int)std::thread::hardware_concurrency();
+        return RunDifficultyEstimate(options.difficultyGames, workers > 0 ? workers : 1, options.errorModel, options.parRate);
+    }
+    if (!options.farmWorkerName.empty()) {
+        return RunFarmWorker(options.farmWorkerName, options.farmWorkerSlot, options.farmWorkerCore);
+    }
+    if (options.farm) {
+        int workers = options.workers > 0 ? options.workers : (int)std::thread::hardware_concurrency();
+        return RunSimulationFarm(options.farmOut, workers > 0 ? workers : 1, options.packPath);
+    }
+
+    SetConfigFlags(FLAG_WINDOW_RESIZABLE | FLAG_WINDOW_HIGHDPI);
+    InitWindow(DEFAULT_SCREEN_WIDTH, DEFAULT_SCREEN_HEIGHT, "Angry Bird - by Abbad & Talal");
+    SetWindowMinSize(DEFAULT_SCREEN_WIDTH / 4, DEFAULT_SCREEN_HEIGHT / 4);
+    SetTargetFPS(TICKS_PER_SECOND);
+
+    if (options.versus) {
+        SetExitKey(KEY_NULL);
+        int result = RunVersus(options.localPort, options.remoteHost.c_str(), options.remotePort, options.level);
+        CloseWindow();
+        return result;
+    }
+    if (!options.spectateHost.empty()) {
+        SetExitKey(KEY_NULL);
+        int result = RunSpectator(options.spectateHost.c_str(), options.spectatePort);
+        CloseWindow();
+        return result;
+    }
+    if (!options.viewReplay.empty()) {
+        SetExitKey(KEY_NULL);
+        int result = RunReplayViewer(options.viewReplay.c_str());
+        CloseWindow();
+        return result;
+    }
+
+    SpectatorServer spectators;
+    if (options.spectatorPort != 0 && !spectators.Start(options.spectatorPort)) {
+        TraceLog(LOG_WARNING, "SPECTATOR: could not open port %d", options.spectatorPort);
+    }
 
-    InitWindow(screenWidth, screenHeight, "Angry Bird - by Abbad & Talal");
-    SetTargetFPS(60);
+    InitAudioDevice();
+    ImpactMixer mixer;
+    activeMixer = &mixer;
+    AudioStream impactStream = {};
+    if (IsAudioDeviceReady()) {
+        SetAudioStreamBufferSizeDefault(MIXER_BLOCK_FRAMES);
+        impactStream = LoadAudioStream(MIXER_SAMPLE_RATE, 16, 2);
+        SetAudioStreamCallback(impactStream, MixImpactAudio);
+        PlayAudioStream(impactStream);
+    }
 
     
-    Texture2D background = LoadTexture("graphics/start_image.png");
-    Texture2D levelSelectBackground = LoadTexture("graphics/level_select_bg.png");
+    Textures().SetBudget((size_t)(options.textureBudgetMb * 1048576.0));
+    TextureHandle background = Textures().Register("graphics/start_image.png");
+    TextureHandle levelSelectBackground = Textures().Register("graphics/level_select_bg.png");
+    bool showTextureOverlay = false;
 
     float buttonScale = 0.65f;
 
@@ -882,11 +6636,6 @@ int main()
     Image exitImage = LoadImage("graphics/exit_button.png");
     Image backImage = LoadImage("graphics/back_button.png");
 
-    
-    Image level1Image = LoadImage("graphics/level1_button.png");
-    Image level2Image = LoadImage("graphics/level2_button.png");
-    Image level3Image = LoadImage("graphics/level3_button.png");
-    Image level4Image = LoadImage("graphics/level4_button.png");
 
     int startButtonWidth = static_cast<int>(startImage.width * buttonScale);
     int startButtonHeight = static_cast<int>(startImage.height * buttonScale);
@@ -897,17 +6646,10 @@ int main()
     int backButtonWidth = static_cast<int>(backImage.width * buttonScale);
     int backButtonHeight = static_cast<int>(backImage.height * buttonScale);
 
-    
-    int levelButtonWidth = static_cast<int>(level1Image.width * buttonScale);
-    int levelButtonHeight = static_cast<int>(level1Image.height * buttonScale);
 
     UnloadImage(startImage);
     UnloadImage(exitImage);
     UnloadImage(backImage);
-    UnloadImage(level1Image);
-    UnloadImage(level2Image);
-    UnloadImage(level3Image);
-    UnloadImage(level4Image);
 
     float centerX_start = (screenWidth - startButtonWidth) / 2.0f;
     float centerX_exit = (screenWidth - exitButtonWidth) / 2.0f;
@@ -917,29 +6659,31 @@ int main()
     float exitButtonY = startButtonY + startButtonHeight + 20;
     float backButtonY = screenHeight - backButtonHeight - 30;
 
-    
-    float levelButtonSpacing = 50.0f;
-    float totalLevelButtonsWidth = 4 * levelButtonWidth + 3 * levelButtonSpacing;
-    float levelButtonsStartX = (screenWidth - totalLevelButtonsWidth) / 2.0f;
-    float levelButtonY = screenHeight / 2.0f - levelButtonHeight / 2.0f;
 
     Button startButton("graphics/start_button.png", { centerX_start, startButtonY }, buttonScale);
     Button exitButton("graphics/exit_button.png", { centerX_exit, exitButtonY }, buttonScale);
     Button backButton("graphics/back_button.png", { centerX_back, backButtonY }, buttonScale);
 
-    
-    Button level1Button("graphics/level1_button.png",
-        { levelButtonsStartX, levelButtonY }, buttonScale);
-    Button level2Button("graphics/level2_button.png",
-        { levelButtonsStartX + levelButtonWidth + levelButtonSpacing, levelButtonY }, buttonScale);
-    Button level3Button("graphics/level3_button.png",
-        { levelButtonsStartX + 2 * (levelButtonWidth + levelButtonSpacing), levelButtonY }, buttonScale);
-    Button level4Button("graphics/level4_button.png",
-        { levelButtonsStartX + 3 * (levelButtonWidth + levelButtonSpacing), levelButtonY }, buttonScale);
+    LevelSelectScreen levelSelect(ActiveCatalog());
+    FrameGraph frameGraph;
 
     
     GameWorld game;
     GameState state = MENU;
+    std::vector<InputFrame> replayInputs;
+    ReplayKeyframes replayKeyframes;
+    time_t sessionStart = time(nullptr);
+
+    game.recordShots = !options.benchmark;
+    std::error_code telemetryError;
+    std::filesystem::create_directories("telemetry", telemetryError);
+    ShotLogWriter shotLog;
+    if (!shotLog.Open("telemetry/shots.shotlog")) {
+        TraceLog(LOG_WARNING, "TELEMETRY: could not open telemetry/shots.shotlog");
+    }
+    double shotFrameMsSum = 0;
+    float shotFrameMsMax = 0;
+    int shotFrames = 0;
 
     
     const char* title = "Angry Birds";
@@ -947,10 +6691,61 @@ int main()
     int fontSize = 60;
     int levelFontSize = 50;
 
+    Recorder().SetBudget(options.hitchBudgetMs);
+
+    // The benchmark runs uncapped and keeps the real mouse out of the
+    // scripted scenes.
+    BenchmarkRun benchmark;
+    if (options.benchmark) {
+        SetTargetFPS(0);
+        benchmark.Start(game);
+    }
+
+    // File changes do not wake an idle loop, so watching keeps it drawing.
+    DirectoryWatcher levelWatcher;
+    if (!options.watchDir.empty() && !levelWatcher.Open(options.watchDir.c_str())) {
+        TraceLog(LOG_WARNING, "WATCH: could not watch %s", options.watchDir.c_str());
+    }
+    std::vector<std::string> changedFiles;
+
+    IdleMode idle(options.idle && !options.benchmark && !levelWatcher.IsOpen());
+
+    // The benchmark measures the game alone.
+    ShotPreview preview;
+    if (!options.benchmark) preview.Start();
+    float titleClock = 0;
+
     while (!WindowShouldClose())
     {
+        idle.Sleep();
+        Recorder().BeginFrame();
+        int64_t updateStart = Recorder().Now();
+        drawSubmissions = 0;
         SetExitKey(KEY_NULL);
-        Vector2 mousePosition = GetMousePosition();
+        Camera2D camera = WorldCamera();
+        Vector2 mousePosition = GetScreenToWorld2D(GetMousePosition(), camera);
+        spectators.Poll();
+        if (IsKeyPressed(KEY_F3)) showTextureOverlay = !showTextureOverlay;
+
+        changedFiles.clear();
+        levelWatcher.Poll(changedFiles);
+        for (const std::string& name : changedFiles) {
+            Level edited;
+            std::filesystem::path path = std::filesystem::path(options.watchDir) / name;
+            if (path.extension() != ".lvl" || !game.initialized || !ParseLevelFile(path.string(), edited)) continue;
+            if (edited.id != game.currentLevel.id) continue;
+
+            int64_t editStart = Recorder().Now();
+            LevelDiff diff = game.ApplyLevelEdit(edited);
+            TraceLog(LOG_INFO, "WATCH: %s: %zu moved, %zu removed, %zu inserted in %.2f ms", name.c_str(),
+                diff.moves.size(), diff.removes.size(), diff.inserts.size(), (Recorder().Now() - editStart) / 1e6);
+        }
+
+        InputFrame scripted;
+        if (benchmark.Running()) {
+            state = benchmark.BeginFrame(game, scripted);
+            mousePosition = { -1.0f, -1.0f };
+        }
 
         
         switch (state) {
@@ -973,20 +6768,17 @@ int main()
             }
 
             
-            if (level1Button.isClicked(mousePosition)) {
-                game.SetLevel(1);
-                state = PLAYING;
-            }
-            else if (level2Button.isClicked(mousePosition)) {
-                game.SetLevel(2);
-                state = PLAYING;
-            }
-            else if (level3Button.isClicked(mousePosition)) {
-                game.SetLevel(3);
-                state = PLAYING;
-            }
-            else if (level4Button.isClicked(mousePosition)) {
-                game.SetLevel(4);
+            uint32_t selectedLevel = levelSelect.Update(mousePosition);
+
+            if (selectedLevel != 0) {
+                InputFrame select;
+                select.flags = INPUT_SELECT;
+                select.level = selectedLevel;
+                Recorder().Input(select.flags, select.level, select.mouseX, select.mouseY);
+                replayKeyframes.Capture(game, (uint32_t)replayInputs.size());
+                replayInputs.push_back(select);
+                game.Step(select);
+                spectators.Publish(game);
                 state = PLAYING;
             }
 
@@ -997,7 +6789,46 @@ int main()
             break;
         }
         case PLAYING: {
-            game.Update();
+            InputFrame input = benchmark.Running() ? scripted : game.SampleInput(camera);
+            Recorder().Input(input.flags, input.level, input.mouseX, input.mouseY);
+            bool wasCompleted = game.currentLevel.state == LevelState::COMPLETED;
+            replayKeyframes.Capture(game, (uint32_t)replayInputs.size());
+            replayInputs.push_back(input);
+            int64_t stepStart = Recorder().Now();
+            game.Step(input);
+            int64_t stepEnd = Recorder().Now();
+            Recorder().Zone("Step", stepStart, stepEnd);
+            if (benchmark.Running()) benchmark.RecordTick(stepEnd - stepStart, game.currentLevel.pairTests);
+            spectators.Publish(game);
+            preview.Update(game);
+            Recorder().Counter("Projectiles", (double)game.projectiles.Size());
+            Recorder().Counter("Shards", (double)game.shards.Active());
+            Recorder().Counter("Pair tests", (double)game.currentLevel.pairTests);
+            mixer.Submit(game.impacts, WORLD_WIDTH);
+
+            if (game.shotInFlight) {
+                float frameMs = GetFrameTime() * 1000.0f;
+                shotFrameMsSum += frameMs;
+                shotFrameMsMax = std::max(shotFrameMsMax, frameMs);
+                shotFrames++;
+            }
+            for (ShotRecord& shot : game.finishedShots) {
+                shot.frameMsAvg = shotFrames > 0 ? (float)(shotFrameMsSum / shotFrames) : 0.0f;
+                shot.frameMsMax = shotFrameMsMax;
+                shotLog.Append(shot);
+                shotFrameMsSum = 0;
+                shotFrameMsMax = 0;
+                shotFrames = 0;
+            }
+            game.finishedShots.clear();
+
+            // A level edited while playing no longer matches what a replay of
+            // it would load, so it is not saved.
+            bool replayable = !options.benchmark && !game.levelEdited;
+            if (!wasCompleted && game.currentLevel.state == LevelState::COMPLETED && replayable) {
+                SaveReplay(replayInputs, replayKeyframes, TextFormat("replays/session_%lld_level%u_%d.abr",
+                    (long long)sessionStart, game.currentLevel.id, game.currentLevel.GetCurrentScore()));
+            }
 
            
             if (IsKeyPressed(KEY_ESCAPE)) {
@@ -1009,97 +6840,130 @@ int main()
             
             break;
         }
+        Recorder().Zone("Update", updateStart, Recorder().Now());
 
-       
-        BeginDrawing();
+        // The title bounce only runs while frames are flowing, so it pauses
+        // where it is instead of jumping when the menu goes idle and wakes.
+        idle.Update(spectators.HasSubscribers() || (state == PLAYING && (game.Animating() || preview.Busy())), spectators.IsRunning());
+        if (!idle.Waiting()) titleClock += std::min(GetFrameTime(), 0.1f);
 
-        switch (state) {
-        case MENU: {
-            DrawTexture(background, 0, 0, WHITE);
+       
+        int64_t drawStart = Recorder().Now();
+        std::vector<FrameResource> screenInputs;
+        if (state == PLAYING) screenInputs.push_back(game.AddPasses(frameGraph, "Damage"));
+        frameGraph.AddPass("Screen", FRAME_BACKBUFFER, screenInputs, 0, [&]() {
+            ClearBackground(BLACK);
+            BeginMode2D(camera);
+
+            switch (state) {
+            case MENU: {
+                DrawTexture(Textures().Get(background), 0, 0, WHITE);
+                drawSubmissions++;
 
             
-            int textWidth = MeasureText(title, fontSize);
-            int titleX = (screenWidth - textWidth) / 2;
+                int textWidth = MeasureText(title, fontSize);
+                int titleX = (screenWidth - textWidth) / 2;
 
             
-            float time = GetTime(); 
-            float bounce = sinf(time * 2.0f) * 10.0f;
-            int titleY = static_cast<int>(startButtonY) - 100 + static_cast<int>(bounce);
+                float bounce = sinf(titleClock * 2.0f) * 10.0f;
+                int titleY = static_cast<int>(startButtonY) - 100 + static_cast<int>(bounce);
 
-            DrawText(title, titleX + 2, titleY + 2, fontSize, DARKGRAY); 
-            DrawText(title, titleX, titleY, fontSize, BLACK);     
+                DrawText(title, titleX + 2, titleY + 2, fontSize, DARKGRAY); 
+                DrawText(title, titleX, titleY, fontSize, BLACK);     
 
-            startButton.Draw();
-            exitButton.Draw();
-            break;
-        }
-        case LEVEL_SELECT: {
-            
-            if (levelSelectBackground.id > 0) {
-                DrawTexturePro(levelSelectBackground,
-                    { 0.0f, 0.0f, (float)levelSelectBackground.width, (float)levelSelectBackground.height },
-                    { 0.0f, 0.0f, (float)screenWidth, (float)screenHeight },
-                    { 0, 0 },
-                    0.0f,
-                    WHITE);
-            }
-            else {
-                ClearBackground(RAYWHITE);
+                startButton.Draw();
+                exitButton.Draw();
+                break;
             }
-
+            case LEVEL_SELECT: {
             
-            int levelTextWidth = MeasureText(levelSelectTitle, levelFontSize);
-            int levelTitleX = (screenWidth - levelTextWidth) / 2;
-            int levelTitleY = 100;
-
-            DrawText(levelSelectTitle, levelTitleX + 2, levelTitleY + 2, levelFontSize, DARKGRAY);
-            DrawText(levelSelectTitle, levelTitleX, levelTitleY, levelFontSize, BLACK);        
+                Texture2D selectBackground = Textures().Get(levelSelectBackground);
+                drawSubmissions++;
+                if (selectBackground.id > 0) {
+                    DrawTexturePro(selectBackground,
+                        { 0.0f, 0.0f, (float)selectBackground.width, (float)selectBackground.height },
+                        { 0.0f, 0.0f, (float)screenWidth, (float)screenHeight },
+                        { 0, 0 },
+                        0.0f,
+                        WHITE);
+                }
+                else {
+                    DrawRectangle(0, 0, screenWidth, screenHeight, RAYWHITE);
+                }
 
             
-            int descFontSize = 18;
-            DrawText("Level 1: Starter Tower",
-                (int)level1Button.position.x, (int)(level1Button.position.y + levelButtonHeight + 10),
-                descFontSize, BLACK);
-            DrawText("Level 2: Fortified Castle",
-                (int)level2Button.position.x, (int)(level2Button.position.y + levelButtonHeight + 10),
-                descFontSize, BLACK);
-            DrawText("Level 3: Stronghold",
-                (int)level3Button.position.x, (int)(level3Button.position.y + levelButtonHeight + 10),
-                descFontSize, BLACK);
-            DrawText("Level 4: Ultimate Challenge",
-                (int)level4Button.position.x, (int)(level4Button.position.y + levelButtonHeight + 10),
-                descFontSize, BLACK);
+                int levelTextWidth = MeasureText(levelSelectTitle, levelFontSize);
+                int levelTitleX = (screenWidth - levelTextWidth) / 2;
+                int levelTitleY = 100;
+
+                DrawText(levelSelectTitle, levelTitleX + 2, levelTitleY + 2, levelFontSize, DARKGRAY);
+                DrawText(levelSelectTitle, levelTitleX, levelTitleY, levelFontSize, BLACK);        
 
             
-            level1Button.Draw();
-            level2Button.Draw();
-            level3Button.Draw();
-            level4Button.Draw();
-            backButton.Draw();
-            break;
-        }
-        case PLAYING: {
-            game.Draw();
-            break;
-        }
-        case EXIT_GAME:
+                levelSelect.Draw(game);
+                backButton.Draw();
+                break;
+            }
+            case PLAYING: {
+                game.Draw();
+                preview.Draw(game);
+                break;
+            }
+            case EXIT_GAME:
             
-            break;
-        }
+                break;
+            }
 
-        EndDrawing();
+            EndMode2D();
+            if (showTextureOverlay) Textures().DrawOverlay(16, 66);
+        });
+        int64_t presentStart = frameGraph.Execute();
+        Recorder().Zone("Draw", drawStart, presentStart);
+        Recorder().Counter("Render passes", (double)frameGraph.Stats().executed);
+        Textures().EndFrame();
+        Recorder().EndFrame(idle.Waiting());
+
+        if (benchmark.Running()) {
+            benchmark.EndFrame(game);
+            if (!benchmark.Running()) state = EXIT_GAME;
+        }
 
         
         if (state == EXIT_GAME) break;
     }
 
+    int exitCode = 0;
+    if (options.benchmark) {
+        if (benchmark.Running()) {
+            fprintf(stderr, "benchmark: window closed before the last scene\n");
+            exitCode = 1;
+        }
+        else if (!benchmark.WriteReport(options.benchmarkOut)) {
+            fprintf(stderr, "benchmark: could not write %s\n", options.benchmarkOut.c_str());
+            exitCode = 1;
+        }
+        else {
+            printf("benchmark: summary written to %s\n", options.benchmarkOut.c_str());
+        }
+    }
+
     
     if (game.initialized) {
         game.Destroy();
     }
+    spectators.Shutdown();
+    shotLog.Close();
+    levelSelect.Unload();
+    frameGraph.Release();
+
+    if (IsAudioDeviceReady()) {
+        StopAudioStream(impactStream);
+        UnloadAudioStream(impactStream);
+    }
+    CloseAudioDevice();
+    activeMixer = nullptr;
 
-    UnloadTexture(background);
-    UnloadTexture(levelSelectBackground);
+    Textures().UnloadAll();
     CloseWindow();
-    return 0;
+    return exitCode;
 }
\ No newline at end of file
@@ -0,0 +1,169 @@
+#include "audio.h"
+#include "random.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MIXER_SSE2 1
+#endif
+
+static const float TWO_PI = 6.28318531f;
+
+// Impulse at which each sound plays at full volume, and its mix level.
+static const float IMPACT_FULL_SCALE[IMPACT_SOUND_COUNT] = { 30.0f, 30.0f, 20.0f };
+static const float IMPACT_VOLUME[IMPACT_SOUND_COUNT] = { 0.45f, 0.35f, 0.8f };
+static const float MIXER_CULL_GAIN = 0.03f;
+
+// The sounds are synthesized once at startup so no audio assets are needed.
+static std::vector<float> SynthesizeImpact(ImpactSound sound) {
+    float seconds = sound == IMPACT_BLAST ? 0.6f : sound == IMPACT_GROUND ? 0.2f : 0.12f;
+    std::vector<float> samples((size_t)(seconds * MIXER_SAMPLE_RATE));
+
+    std::vector<float> noiseSamples(samples.size());
+    RandomStream(0, RANDOM_AUDIO, (uint32_t)sound).FillFloats(noiseSamples.data(), noiseSamples.size());
+
+    float lowpass = 0;
+    float peak = 0;
+    for (size_t i = 0; i < samples.size(); ++i) {
+        float t = (float)i / MIXER_SAMPLE_RATE;
+        float noise = 2.0f * noiseSamples[i] - 1.0f;
+
+        float value = 0;
+        if (sound == IMPACT_BLOCK) {
+            lowpass += 0.35f * (noise - lowpass);
+            value = (lowpass + 0.5f * std::sin(TWO_PI * 180.0f * t)) * std::exp(-30.0f * t);
+        }
+        else if (sound == IMPACT_GROUND) {
+            float frequency = 50.0f + 40.0f * std::exp(-20.0f * t);
+            value = (std::sin(TWO_PI * frequency * t) + 0.1f * noise) * std::exp(-18.0f * t);
+        }
+        else {
+            lowpass += 0.08f * (noise - lowpass);
+            value = (2.0f * lowpass + 0.6f * std::sin(TWO_PI * 40.0f * t)) * std::exp(-6.0f * t);
+        }
+
+        samples[i] = value;
+        peak = std::max(peak, std::fabs(value));
+    }
+
+    for (float& sample : samples) sample *= 0.8f / peak;
+    return samples;
+}
+
+ImpactMixer::ImpactMixer() : accumulator(MIXER_BLOCK_FRAMES * 2) {
+    for (int sound = 0; sound < IMPACT_SOUND_COUNT; ++sound) {
+        bank[sound] = SynthesizeImpact((ImpactSound)sound);
+    }
+}
+
+void ImpactMixer::Submit(const ImpactEvents& events, float worldWidth) {
+    std::array<Request, IMPACT_SOUND_COUNT> audible;
+    int count = 0;
+
+    for (int sound = 0; sound < IMPACT_SOUND_COUNT; ++sound) {
+        const ImpactEvent& event = events[sound];
+        if (event.count == 0) continue;
+
+        // Many simultaneous hits sound louder than one, but not many times louder.
+        float crowd = std::min(2.0f, 1.0f + 0.3f * std::log2((float)event.count));
+        float gain = std::min(1.0f, event.impulse / IMPACT_FULL_SCALE[sound]) * crowd * IMPACT_VOLUME[sound];
+        if (gain < MIXER_CULL_GAIN) continue;
+
+        Request& request = audible[count++];
+        request.sound = (uint8_t)sound;
+        request.gain = std::min(1.0f, gain);
+        request.pan = std::max(-1.0f, std::min(1.0f, 2.0f * event.X() / worldWidth - 1.0f));
+    }
+
+    std::sort(audible.begin(), audible.begin() + count, [](const Request& a, const Request& b) {
+        return a.gain > b.gain;
+    });
+
+    uint32_t head = requestHead.load(std::memory_order_relaxed);
+    for (int i = 0; i < count; ++i) {
+        if (head - requestTail.load(std::memory_order_acquire) >= MIXER_REQUEST_CAPACITY) break;
+        requests[head % MIXER_REQUEST_CAPACITY] = audible[i];
+        head++;
+    }
+    requestHead.store(head, std::memory_order_release);
+}
+
+// Takes a free voice, or steals the one with the least left to say if the
+// new sound is louder than it.
+void ImpactMixer::Start(const Request& request) {
+    Voice* target = &voices[0];
+    for (Voice& voice : voices) {
+        if (voice.Loudness() < target->Loudness()) target = &voice;
+    }
+    if (target->Active() && target->Loudness() >= request.gain) return;
+
+    const std::vector<float>& samples = bank[request.sound];
+    float angle = (request.pan + 1.0f) * 0.25f * 3.14159265f;
+    target->samples = samples.data();
+    target->length = (uint32_t)samples.size();
+    target->position = 0;
+    target->gain = request.gain;
+    target->gainLeft = request.gain * std::cos(angle);
+    target->gainRight = request.gain * std::sin(angle);
+}
+
+void ImpactMixer::Mix(int16_t* out, unsigned int frames) {
+    uint32_t tail = requestTail.load(std::memory_order_relaxed);
+    uint32_t head = requestHead.load(std::memory_order_acquire);
+    for (; tail != head; ++tail) {
+        Start(requests[tail % MIXER_REQUEST_CAPACITY]);
+    }
+    requestTail.store(tail, std::memory_order_release);
+
+    while (frames > 0) {
+        unsigned int block = std::min(frames, (unsigned int)MIXER_BLOCK_FRAMES);
+        MixBlock(out, block);
+        out += block * 2;
+        frames -= block;
+    }
+}
+
+void ImpactMixer::MixBlock(int16_t* out, unsigned int frames) {
+    float* mix = accumulator.data();
+    std::fill(mix, mix + frames * 2, 0.0f);
+
+    for (Voice& voice : voices) {
+        if (!voice.Active()) continue;
+
+        uint32_t count = std::min((uint32_t)frames, voice.length - voice.position);
+        const float* source = voice.samples + voice.position;
+        uint32_t i = 0;
+#ifdef MIXER_SSE2
+        __m128 gains = _mm_setr_ps(voice.gainLeft, voice.gainRight, voice.gainLeft, voice.gainRight);
+        for (; i + 4 <= count; i += 4) {
+            __m128 mono = _mm_loadu_ps(source + i);
+            __m128 first = _mm_mul_ps(_mm_unpacklo_ps(mono, mono), gains);
+            __m128 second = _mm_mul_ps(_mm_unpackhi_ps(mono, mono), gains);
+            _mm_storeu_ps(mix + 2 * i, _mm_add_ps(_mm_loadu_ps(mix + 2 * i), first));
+            _mm_storeu_ps(mix + 2 * i + 4, _mm_add_ps(_mm_loadu_ps(mix + 2 * i + 4), second));
+        }
+#endif
+        for (; i < count; ++i) {
+            mix[2 * i] += source[i] * voice.gainLeft;
+            mix[2 * i + 1] += source[i] * voice.gainRight;
+        }
+        voice.position += count;
+    }
+
+    unsigned int samples = frames * 2;
+    unsigned int i = 0;
+#ifdef MIXER_SSE2
+    __m128 scale = _mm_set1_ps(32767.0f);
+    for (; i + 8 <= samples; i += 8) {
+        __m128i low = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(mix + i), scale));
+        __m128i high = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(mix + i + 4), scale));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(low, high));
+    }
+#endif
+    for (; i < samples; ++i) {
+        float value = std::max(-1.0f, std::min(1.0f, mix[i]));
+        out[i] = (int16_t)std::lrintf(value * 32767.0f);
+    }
+}
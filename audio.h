@@ -0,0 +1,110 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+enum ImpactSound {
+    IMPACT_BLOCK,
+    IMPACT_GROUND,
+    IMPACT_BLAST,
+    IMPACT_SOUND_COUNT
+};
+
+// Every impact of one sound within a tick, merged into a single event.
+struct ImpactEvent {
+    uint32_t count = 0;
+    float impulse = 0;
+    float totalImpulse = 0;
+    float weightedX = 0;
+    float weightedY = 0;
+
+    float X() const {
+        return totalImpulse > 0 ? weightedX / totalImpulse : 0.0f;
+    }
+
+    float Y() const {
+        return totalImpulse > 0 ? weightedY / totalImpulse : 0.0f;
+    }
+};
+
+// Impacts raised by the simulation during one tick. Adding coalesces by
+// sound, so a collapsing tower costs the same as a single hit.
+class ImpactEvents {
+private:
+    std::array<ImpactEvent, IMPACT_SOUND_COUNT> events;
+
+public:
+    void Add(ImpactSound sound, float x, float y, float impulse) {
+        ImpactEvent& event = events[sound];
+        event.count++;
+        event.impulse = impulse > event.impulse ? impulse : event.impulse;
+        event.totalImpulse += impulse;
+        event.weightedX += x * impulse;
+        event.weightedY += y * impulse;
+    }
+
+    void Clear() {
+        events = {};
+    }
+
+    const ImpactEvent& operator[](int sound) const {
+        return events[sound];
+    }
+};
+
+constexpr int MIXER_SAMPLE_RATE = 44100;
+constexpr int MIXER_VOICES = 16;
+constexpr int MIXER_BLOCK_FRAMES = 512;
+constexpr int MIXER_REQUEST_CAPACITY = 64;
+
+// Fixed-voice mixer for impact sounds. The game thread submits one tick of
+// events at a time; the audio thread drains them into the voice pool and
+// mixes. The two sides share only a single-producer single-consumer ring,
+// and the audio side never allocates, so its cost is bounded by the voice
+// count however much is destroyed.
+class ImpactMixer {
+private:
+    struct Voice {
+        const float* samples = nullptr;
+        uint32_t length = 0;
+        uint32_t position = 0;
+        float gainLeft = 0;
+        float gainRight = 0;
+        float gain = 0;
+
+        bool Active() const {
+            return position < length;
+        }
+
+        float Loudness() const {
+            return Active() ? gain * (1.0f - (float)position / length) : 0.0f;
+        }
+    };
+
+    struct Request {
+        uint8_t sound = 0;
+        float gain = 0;
+        float pan = 0;
+    };
+
+    std::array<std::vector<float>, IMPACT_SOUND_COUNT> bank;
+    std::array<Voice, MIXER_VOICES> voices;
+    std::array<Request, MIXER_REQUEST_CAPACITY> requests;
+    std::atomic<uint32_t> requestHead{ 0 };
+    std::atomic<uint32_t> requestTail{ 0 };
+    std::vector<float> accumulator;
+
+    void Start(const Request& request);
+    void MixBlock(int16_t* out, unsigned int frames);
+
+public:
+    ImpactMixer();
+
+    // Game thread. Queues the audible events of one tick, loudest first.
+    void Submit(const ImpactEvents& events, float worldWidth);
+
+    // Audio thread. Fills interleaved 16-bit stereo frames.
+    void Mix(int16_t* out, unsigned int frames);
+};
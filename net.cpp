@@ -0,0 +1,244 @@
+#include "net.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+typedef int socklen_t;
+typedef SOCKET NativeSocket;
+static const intptr_t INVALID_HANDLE = (intptr_t)INVALID_SOCKET;
+#else
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int NativeSocket;
+static const intptr_t INVALID_HANDLE = -1;
+#endif
+
+#include <cstring>
+
+static bool WouldBlock() {
+#ifdef _WIN32
+    int error = WSAGetLastError();
+    return error == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+}
+
+static NativeSocket ToNative(intptr_t handle) {
+    return (NativeSocket)handle;
+}
+
+static void CloseSocketHandle(intptr_t handle) {
+#ifdef _WIN32
+    closesocket(ToNative(handle));
+#else
+    close(ToNative(handle));
+#endif
+}
+
+static bool SetNonBlocking(intptr_t handle) {
+#ifdef _WIN32
+    u_long mode = 1;
+    return ioctlsocket(ToNative(handle), FIONBIO, &mode) == 0;
+#else
+    int flags = fcntl(ToNative(handle), F_GETFL, 0);
+    return flags != -1 && fcntl(ToNative(handle), F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+static sockaddr_in ToSockAddr(const NetAddress& address) {
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(address.host);
+    addr.sin_port = htons(address.port);
+    return addr;
+}
+
+bool NetStartup() {
+#ifdef _WIN32
+    WSADATA data;
+    return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+#else
+    return true;
+#endif
+}
+
+void NetShutdown() {
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+bool ResolveAddress(const char* hostName, uint16_t port, NetAddress& out) {
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    addrinfo* result = nullptr;
+    if (getaddrinfo(hostName, nullptr, &hints, &result) != 0 || result == nullptr) {
+        return false;
+    }
+
+    const sockaddr_in* addr = reinterpret_cast<const sockaddr_in*>(result->ai_addr);
+    out.host = ntohl(addr->sin_addr.s_addr);
+    out.port = port;
+    freeaddrinfo(result);
+    return true;
+}
+
+UdpSocket::UdpSocket() : handle(INVALID_HANDLE) {}
+
+UdpSocket::~UdpSocket() {
+    Close();
+}
+
+bool UdpSocket::Open(uint16_t localPort) {
+    Close();
+
+    handle = (intptr_t)socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (handle == INVALID_HANDLE) return false;
+
+    sockaddr_in addr = ToSockAddr({ INADDR_ANY, localPort });
+    if (bind(ToNative(handle), reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 || !SetNonBlocking(handle)) {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void UdpSocket::Close() {
+    if (handle != INVALID_HANDLE) {
+        CloseSocketHandle(handle);
+        handle = INVALID_HANDLE;
+    }
+}
+
+bool UdpSocket::IsOpen() const {
+    return handle != INVALID_HANDLE;
+}
+
+bool UdpSocket::SendTo(const NetAddress& to, const void* data, size_t size) {
+    if (handle == INVALID_HANDLE) return false;
+
+    sockaddr_in addr = ToSockAddr(to);
+    int sent = sendto(ToNative(handle), static_cast<const char*>(data), (int)size, 0,
+        reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+    return sent == (int)size;
+}
+
+int UdpSocket::ReceiveFrom(NetAddress& from, void* buffer, size_t capacity) {
+    if (handle == INVALID_HANDLE) return -1;
+
+    sockaddr_in addr;
+    socklen_t addrLength = sizeof(addr);
+    int received = recvfrom(ToNative(handle), static_cast<char*>(buffer), (int)capacity, 0,
+        reinterpret_cast<sockaddr*>(&addr), &addrLength);
+
+    if (received < 0) {
+        return WouldBlock() ? 0 : -1;
+    }
+
+    from.host = ntohl(addr.sin_addr.s_addr);
+    from.port = ntohs(addr.sin_port);
+    return received;
+}
+
+TcpSocket::TcpSocket() : handle(INVALID_HANDLE) {}
+
+TcpSocket::~TcpSocket() {
+    Close();
+}
+
+bool TcpSocket::Listen(uint16_t port, bool loopbackOnly) {
+    Close();
+
+    handle = (intptr_t)socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (handle == INVALID_HANDLE) return false;
+
+    int reuse = 1;
+    setsockopt(ToNative(handle), SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+    sockaddr_in addr = ToSockAddr({ loopbackOnly ? (uint32_t)INADDR_LOOPBACK : (uint32_t)INADDR_ANY, port });
+    if (bind(ToNative(handle), reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(ToNative(handle), SOMAXCONN) != 0) {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+bool TcpSocket::Accept(TcpSocket& client) {
+    if (handle == INVALID_HANDLE) return false;
+
+    intptr_t accepted = (intptr_t)accept(ToNative(handle), nullptr, nullptr);
+    if (accepted == INVALID_HANDLE) return false;
+
+    int noDelay = 1;
+    setsockopt(ToNative(accepted), IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+
+    client.Close();
+    client.handle = accepted;
+    return true;
+}
+
+bool TcpSocket::Connect(const NetAddress& to) {
+    Close();
+
+    handle = (intptr_t)socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (handle == INVALID_HANDLE) return false;
+
+    sockaddr_in addr = ToSockAddr(to);
+    if (connect(ToNative(handle), reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+        Close();
+        return false;
+    }
+
+    int noDelay = 1;
+    setsockopt(ToNative(handle), IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+    return true;
+}
+
+void TcpSocket::Close() {
+    if (handle != INVALID_HANDLE) {
+        CloseSocketHandle(handle);
+        handle = INVALID_HANDLE;
+    }
+}
+
+bool TcpSocket::IsOpen() const {
+    return handle != INVALID_HANDLE;
+}
+
+bool TcpSocket::SendAll(const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        int sent = send(ToNative(handle), bytes, (int)size, 0);
+        if (sent <= 0) return false;
+        bytes += sent;
+        size -= (size_t)sent;
+    }
+    return true;
+}
+
+bool TcpSocket::ReceiveAll(void* buffer, size_t size) {
+    char* bytes = static_cast<char*>(buffer);
+    while (size > 0) {
+        int received = recv(ToNative(handle), bytes, (int)size, 0);
+        if (received <= 0) return false;
+        bytes += received;
+        size -= (size_t)received;
+    }
+    return true;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// IPv4 endpoint in host byte order.
+struct NetAddress {
+    uint32_t host = 0;
+    uint16_t port = 0;
+
+    bool operator==(const NetAddress& other) const {
+        return host == other.host && port == other.port;
+    }
+};
+
+bool NetStartup();
+void NetShutdown();
+bool ResolveAddress(const char* hostName, uint16_t port, NetAddress& out);
+
+// Non-blocking UDP socket. Receive calls return 0 when nothing is queued
+// and -1 on error, including a peer whose port refused an earlier send.
+class UdpSocket {
+private:
+    intptr_t handle;
+
+public:
+    UdpSocket();
+    ~UdpSocket();
+
+    UdpSocket(const UdpSocket&) = delete;
+    UdpSocket& operator=(const UdpSocket&) = delete;
+
+    bool Open(uint16_t localPort);
+    void Close();
+    bool IsOpen() const;
+
+    bool SendTo(const NetAddress& to, const void* data, size_t size);
+    int ReceiveFrom(NetAddress& from, void* buffer, size_t capacity);
+};
+
+// Blocking TCP socket, used for the local request/response services.
+class TcpSocket {
+private:
+    intptr_t handle;
+
+public:
+    TcpSocket();
+    ~TcpSocket();
+
+    TcpSocket(const TcpSocket&) = delete;
+    TcpSocket& operator=(const TcpSocket&) = delete;
+
+    bool Listen(uint16_t port, bool loopbackOnly);
+    bool Accept(TcpSocket& client);
+    bool Connect(const NetAddress& to);
+    void Close();
+    bool IsOpen() const;
+
+    bool SendAll(const void* data, size_t size);
+    bool ReceiveAll(void* buffer, size_t size);
+};
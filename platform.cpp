@@ -0,0 +1,480 @@
+#include "platform.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+double ThreadCpuSeconds() {
+#ifdef _WIN32
+    FILETIME creation, exitTime, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exitTime, &kernel, &user)) return 0.0;
+
+    ULARGE_INTEGER kernelTime, userTime;
+    kernelTime.LowPart = kernel.dwLowDateTime;
+    kernelTime.HighPart = kernel.dwHighDateTime;
+    userTime.LowPart = user.dwLowDateTime;
+    userTime.HighPart = user.dwHighDateTime;
+    return (kernelTime.QuadPart + userTime.QuadPart) * 1e-7;
+#else
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+#endif
+}
+
+MappedFile::MappedFile() : data(nullptr), size(0), fileHandle(-1), mappingHandle(-1) {}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+bool MappedFile::Open(const char* path) {
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+        OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle = (intptr_t)file;
+    mappingHandle = (intptr_t)mapping;
+    data = static_cast<const unsigned char*>(view);
+    size = (size_t)fileSize.QuadPart;
+#else
+    int file = open(path, O_RDONLY);
+    if (file < 0) return false;
+
+    struct stat info;
+    if (fstat(file, &info) != 0 || info.st_size == 0) {
+        close(file);
+        return false;
+    }
+
+    void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    if (view == MAP_FAILED) {
+        close(file);
+        return false;
+    }
+    madvise(view, (size_t)info.st_size, MADV_SEQUENTIAL);
+
+    fileHandle = file;
+    data = static_cast<const unsigned char*>(view);
+    size = (size_t)info.st_size;
+#endif
+    return true;
+}
+
+void MappedFile::Close() {
+    if (data == nullptr) return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle((HANDLE)mappingHandle);
+    CloseHandle((HANDLE)fileHandle);
+#else
+    munmap(const_cast<unsigned char*>(data), size);
+    close((int)fileHandle);
+#endif
+
+    data = nullptr;
+    size = 0;
+    fileHandle = -1;
+    mappingHandle = -1;
+}
+
+DirectoryWatcher::DirectoryWatcher() : handle(-1), overlapped(nullptr), buffer(64 * 1024) {}
+
+DirectoryWatcher::~DirectoryWatcher() {
+    Close();
+}
+
+bool DirectoryWatcher::Open(const char* directory) {
+    Close();
+
+#ifdef _WIN32
+    HANDLE dir = CreateFileA(directory, FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    if (dir == INVALID_HANDLE_VALUE) return false;
+
+    handle = (intptr_t)dir;
+    overlapped = new OVERLAPPED();
+    if (!Arm()) {
+        Close();
+        return false;
+    }
+#else
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) return false;
+    if (inotify_add_watch(fd, directory, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        close(fd);
+        return false;
+    }
+    handle = fd;
+#endif
+    return true;
+}
+
+// Windows only: queues the next asynchronous read of directory changes.
+bool DirectoryWatcher::Arm() {
+#ifdef _WIN32
+    OVERLAPPED* pending = static_cast<OVERLAPPED*>(overlapped);
+    *pending = OVERLAPPED();
+    return ReadDirectoryChangesW((HANDLE)handle, buffer.data(), (DWORD)buffer.size(), FALSE,
+        FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE, nullptr, pending, nullptr) != 0;
+#else
+    return true;
+#endif
+}
+
+void DirectoryWatcher::Close() {
+    if (handle == -1) return;
+
+#ifdef _WIN32
+    CancelIo((HANDLE)handle);
+    CloseHandle((HANDLE)handle);
+    delete static_cast<OVERLAPPED*>(overlapped);
+    overlapped = nullptr;
+#else
+    close((int)handle);
+#endif
+    handle = -1;
+}
+
+void DirectoryWatcher::Poll(std::vector<std::string>& changed) {
+    if (handle == -1) return;
+    size_t first = changed.size();
+
+#ifdef _WIN32
+    DWORD bytes = 0;
+    if (!GetOverlappedResult((HANDLE)handle, static_cast<OVERLAPPED*>(overlapped), &bytes, FALSE)) return;
+
+    for (DWORD offset = 0; bytes > 0;) {
+        const FILE_NOTIFY_INFORMATION* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(buffer.data() + offset);
+        if (info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_MODIFIED || info->Action == FILE_ACTION_RENAMED_NEW_NAME) {
+            int wideLength = (int)(info->FileNameLength / sizeof(WCHAR));
+            int length = WideCharToMultiByte(CP_UTF8, 0, info->FileName, wideLength, nullptr, 0, nullptr, nullptr);
+            std::string name(length, '\0');
+            WideCharToMultiByte(CP_UTF8, 0, info->FileName, wideLength, &name[0], length, nullptr, nullptr);
+            changed.push_back(name);
+        }
+        if (info->NextEntryOffset == 0) break;
+        offset += info->NextEntryOffset;
+    }
+    Arm();
+#else
+    for (;;) {
+        ssize_t bytes = read((int)handle, buffer.data(), buffer.size());
+        if (bytes <= 0) break;
+
+        for (ssize_t offset = 0; offset < bytes;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+            if (event->len > 0) changed.push_back(event->name);
+            offset += sizeof(inotify_event) + event->len;
+        }
+    }
+#endif
+
+    std::sort(changed.begin() + first, changed.end());
+    changed.erase(std::unique(changed.begin() + first, changed.end()), changed.end());
+}
+
+SharedMemory::SharedMemory() : data(nullptr), size(0), handle(-1), owner(false) {}
+
+SharedMemory::~SharedMemory() {
+    Close();
+}
+
+bool SharedMemory::Create(const std::string& sharedName, size_t sharedSize) {
+    Close();
+
+#ifdef _WIN32
+    std::string path = "Local\\" + sharedName;
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+        (DWORD)((uint64_t)sharedSize >> 32), (DWORD)sharedSize, path.c_str());
+    if (mapping == nullptr) return false;
+    if (GetLastError() == ERROR_ALREADY_EXISTS) {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, sharedSize);
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        return false;
+    }
+    handle = (intptr_t)mapping;
+#else
+    std::string path = "/" + sharedName;
+    int fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) return false;
+    if (ftruncate(fd, (off_t)sharedSize) != 0) {
+        close(fd);
+        shm_unlink(path.c_str());
+        return false;
+    }
+
+    void* view = mmap(nullptr, sharedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) {
+        shm_unlink(path.c_str());
+        return false;
+    }
+#endif
+
+    data = view;
+    size = sharedSize;
+    name = sharedName;
+    owner = true;
+    return true;
+}
+
+bool SharedMemory::Open(const std::string& sharedName, size_t sharedSize) {
+    Close();
+
+#ifdef _WIN32
+    std::string path = "Local\\" + sharedName;
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, path.c_str());
+    if (mapping == nullptr) return false;
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, sharedSize);
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        return false;
+    }
+    handle = (intptr_t)mapping;
+#else
+    std::string path = "/" + sharedName;
+    int fd = shm_open(path.c_str(), O_RDWR, 0600);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sharedSize) {
+        close(fd);
+        return false;
+    }
+
+    void* view = mmap(nullptr, sharedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) return false;
+#endif
+
+    data = view;
+    size = sharedSize;
+    name = sharedName;
+    owner = false;
+    return true;
+}
+
+void SharedMemory::Close() {
+    if (data == nullptr) return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle((HANDLE)handle);
+#else
+    munmap(data, size);
+    if (owner) shm_unlink(("/" + name).c_str());
+#endif
+
+    data = nullptr;
+    size = 0;
+    handle = -1;
+    name.clear();
+    owner = false;
+}
+
+ChildProcess::ChildProcess() : handle(-1), exitCode(0) {}
+
+ChildProcess::~ChildProcess() {
+#ifdef _WIN32
+    if (handle != -1) CloseHandle((HANDLE)handle);
+#endif
+}
+
+bool ChildProcess::Start(const std::vector<std::string>& args) {
+    if (args.empty() || handle != -1) return false;
+    exitCode = 0;
+
+#ifdef _WIN32
+    std::string commandLine;
+    for (const std::string& arg : args) {
+        if (!commandLine.empty()) commandLine += ' ';
+        commandLine += '"' + arg + '"';
+    }
+
+    STARTUPINFOA startup = {};
+    startup.cb = sizeof(startup);
+    PROCESS_INFORMATION process = {};
+    if (!CreateProcessA(args[0].c_str(), &commandLine[0], nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startup, &process)) {
+        return false;
+    }
+    CloseHandle(process.hThread);
+    handle = (intptr_t)process.hProcess;
+#else
+    std::vector<char*> argv;
+    for (const std::string& arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(nullptr);
+
+    pid_t pid;
+    if (posix_spawn(&pid, args[0].c_str(), nullptr, nullptr, argv.data(), environ) != 0) return false;
+    handle = pid;
+#endif
+    return true;
+}
+
+bool ChildProcess::Running() {
+    if (handle == -1) return false;
+
+#ifdef _WIN32
+    if (WaitForSingleObject((HANDLE)handle, 0) == WAIT_TIMEOUT) return true;
+
+    DWORD code = 0;
+    GetExitCodeProcess((HANDLE)handle, &code);
+    // Crashes end with an NTSTATUS exception code, which has the top bit set.
+    exitCode = (code & 0x80000000u) ? -1 : (int)code;
+    CloseHandle((HANDLE)handle);
+#else
+    int status = 0;
+    pid_t result = waitpid((pid_t)handle, &status, WNOHANG);
+    if (result == 0) return true;
+
+    exitCode = result > 0 && WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+#endif
+    handle = -1;
+    return false;
+}
+
+void ChildProcess::Kill() {
+    if (handle == -1) return;
+
+#ifdef _WIN32
+    TerminateProcess((HANDLE)handle, 0xC0000001u);
+#else
+    kill((pid_t)handle, SIGKILL);
+#endif
+}
+
+std::string ExecutablePath() {
+#ifdef _WIN32
+    char path[MAX_PATH];
+    DWORD length = GetModuleFileNameA(nullptr, path, MAX_PATH);
+    return std::string(path, length);
+#else
+    char path[4096];
+    ssize_t length = readlink("/proc/self/exe", path, sizeof(path));
+    return length > 0 ? std::string(path, (size_t)length) : std::string();
+#endif
+}
+
+uint32_t CurrentProcessId() {
+#ifdef _WIN32
+    return (uint32_t)GetCurrentProcessId();
+#else
+    return (uint32_t)getpid();
+#endif
+}
+
+std::vector<int> CoresByNumaNode() {
+    std::vector<std::vector<int>> nodes;
+
+#ifdef _WIN32
+    ULONG highestNode = 0;
+    if (GetNumaHighestNodeNumber(&highestNode)) {
+        for (ULONG node = 0; node <= highestNode; ++node) {
+            ULONGLONG mask = 0;
+            if (!GetNumaNodeProcessorMask((UCHAR)node, &mask) || mask == 0) continue;
+            nodes.emplace_back();
+            for (int core = 0; core < 64; ++core) {
+                if (mask & (1ull << core)) nodes.back().push_back(core);
+            }
+        }
+    }
+#else
+    // /sys/devices/system/node/nodeN/cpulist reads like "0-7,16-23".
+    for (int node = 0;; ++node) {
+        std::string path = "/sys/devices/system/node/node" + std::to_string(node) + "/cpulist";
+        FILE* file = fopen(path.c_str(), "r");
+        if (file == nullptr) break;
+
+        std::vector<int> cores;
+        int first, last;
+        while (fscanf(file, "%d", &first) == 1) {
+            last = first;
+            if (fscanf(file, "-%d", &last) != 1) last = first;
+            for (int core = first; core <= last; ++core) cores.push_back(core);
+            if (fgetc(file) != ',') break;
+        }
+        fclose(file);
+        if (!cores.empty()) nodes.push_back(cores);
+    }
+#endif
+
+    std::vector<int> order;
+    if (nodes.empty()) {
+        int count = std::max(1, (int)std::thread::hardware_concurrency());
+        for (int core = 0; core < count; ++core) order.push_back(core);
+        return order;
+    }
+
+    for (size_t i = 0;; ++i) {
+        bool any = false;
+        for (const auto& cores : nodes) {
+            if (i < cores.size()) {
+                order.push_back(cores[i]);
+                any = true;
+            }
+        }
+        if (!any) break;
+    }
+    return order;
+}
+
+bool PinCurrentThread(int core) {
+#ifdef _WIN32
+    if (core < 0 || core >= 64) return false;
+    return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << core) != 0;
+#else
+    if (core < 0 || core >= CPU_SETSIZE) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#endif
+}
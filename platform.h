@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// OS services that need <windows.h> or POSIX headers. Kept out of the files
+// that include raylib.h, whose names clash with the Win32 API.
+
+double ThreadCpuSeconds();
+
+// Read-only memory mapping of a whole file.
+class MappedFile {
+private:
+    const unsigned char* data;
+    size_t size;
+    intptr_t fileHandle;
+    intptr_t mappingHandle;
+
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const char* path);
+    void Close();
+
+    const unsigned char* Data() const { return data; }
+    size_t Size() const { return size; }
+};
+
+// Non-blocking watch on one directory for files that were written or moved
+// in (inotify on Linux, ReadDirectoryChangesW on Windows).
+class DirectoryWatcher {
+private:
+    intptr_t handle;
+    void* overlapped;
+    std::vector<unsigned char> buffer;
+
+    bool Arm();
+
+public:
+    DirectoryWatcher();
+    ~DirectoryWatcher();
+
+    DirectoryWatcher(const DirectoryWatcher&) = delete;
+    DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+    bool Open(const char* directory);
+    void Close();
+    bool IsOpen() const { return handle != -1; }
+
+    // Appends the names, relative to the directory, of files changed since
+    // the last call. A file written several times is listed once.
+    void Poll(std::vector<std::string>& changed);
+};
+
+// Named read-write memory shared between processes. The creator owns the
+// name and removes it on Close; processes that Open it only unmap.
+class SharedMemory {
+private:
+    void* data;
+    size_t size;
+    intptr_t handle;
+    std::string name;
+    bool owner;
+
+public:
+    SharedMemory();
+    ~SharedMemory();
+
+    SharedMemory(const SharedMemory&) = delete;
+    SharedMemory& operator=(const SharedMemory&) = delete;
+
+    // Zero-filled on creation. Fails if the name is already taken.
+    bool Create(const std::string& name, size_t size);
+    bool Open(const std::string& name, size_t size);
+    void Close();
+
+    void* Data() const { return data; }
+    size_t Size() const { return size; }
+};
+
+// A child process started from an argument list; args[0] is the program.
+class ChildProcess {
+private:
+    intptr_t handle;
+    int exitCode;
+
+public:
+    ChildProcess();
+    ~ChildProcess();
+
+    ChildProcess(const ChildProcess&) = delete;
+    ChildProcess& operator=(const ChildProcess&) = delete;
+
+    bool Start(const std::vector<std::string>& args);
+
+    // Does not block. Once it returns false, ExitCode() holds the exit code,
+    // or -1 if the process was killed or crashed.
+    bool Running();
+    void Kill();
+    int ExitCode() const { return exitCode; }
+};
+
+std::string ExecutablePath();
+uint32_t CurrentProcessId();
+
+// Logical cores ordered so that consecutive entries alternate between NUMA
+// nodes; handing them out in order spreads work evenly over the nodes.
+std::vector<int> CoresByNumaNode();
+bool PinCurrentThread(int core);
@@ -0,0 +1,136 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <vector>
+
+static const int64_t NANOSECONDS_PER_SECOND = 1000000000;
+
+static int64_t SteadyNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool WriteChromeTrace(const std::string& path, const std::vector<ProfileEvent>& events, double hitchMs) {
+    FILE* file = fopen(path.c_str(), "w");
+    if (file == nullptr) return false;
+
+    fprintf(file, "{\"otherData\":{\"hitchMs\":%.3f},\"traceEvents\":[\n", hitchMs);
+    for (size_t i = 0; i < events.size(); ++i) {
+        const ProfileEvent& event = events[i];
+        double ts = event.start / 1000.0;
+        const char* separator = i + 1 < events.size() ? "," : "";
+
+        switch (event.type) {
+        case PROFILE_FRAME:
+        case PROFILE_ZONE:
+            fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1}%s\n",
+                event.name, ts, (event.end - event.start) / 1000.0, separator);
+            break;
+        case PROFILE_COUNTER:
+            fprintf(file, "{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"args\":{\"value\":%g}}%s\n",
+                event.name, ts, event.value, separator);
+            break;
+        case PROFILE_INPUT:
+            fprintf(file, "{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":1,"
+                "\"args\":{\"flags\":%d,\"level\":%u,\"x\":%d,\"y\":%d}}%s\n",
+                event.name, ts, event.args[0], (uint32_t)event.args[1], event.args[2], event.args[3], separator);
+            break;
+        }
+    }
+    fprintf(file, "]}\n");
+    return fclose(file) == 0;
+}
+
+FlightRecorder::FlightRecorder() : origin(SteadyNanoseconds()) {}
+
+FlightRecorder::~FlightRecorder() {
+    if (writer.joinable()) writer.join();
+}
+
+int64_t FlightRecorder::Now() const {
+    return SteadyNanoseconds() - origin;
+}
+
+ProfileEvent& FlightRecorder::Push(ProfileEventType type, const char* name) {
+    ProfileEvent& event = ring[written++ % PROFILE_RING_CAPACITY];
+    event.type = type;
+    event.name = name;
+    return event;
+}
+
+void FlightRecorder::BeginFrame() {
+    frameStart = Now();
+}
+
+void FlightRecorder::EndFrame(bool waited) {
+    int64_t now = Now();
+    ProfileEvent& event = Push(PROFILE_FRAME, waited ? "Idle frame" : "Frame");
+    event.start = frameStart;
+    event.end = now;
+    frame++;
+
+    double frameMs = (now - frameStart) / 1e6;
+    bool cooledDown = lastDump < 0 || now - lastDump > (int64_t)(PROFILE_DUMP_COOLDOWN_SECONDS * NANOSECONDS_PER_SECOND);
+    if (!waited && budgetMs > 0 && frameMs > budgetMs && frame > PROFILE_WARMUP_FRAMES && hitchStart < 0 && cooledDown) {
+        hitchStart = frameStart;
+        hitchEnd = now;
+    }
+
+    if (hitchStart >= 0 && now - hitchEnd > (int64_t)(PROFILE_WINDOW_AFTER_SECONDS * NANOSECONDS_PER_SECOND)) {
+        StartDump();
+        lastDump = now;
+        hitchStart = hitchEnd = -1;
+    }
+}
+
+void FlightRecorder::Zone(const char* name, int64_t start, int64_t end) {
+    ProfileEvent& event = Push(PROFILE_ZONE, name);
+    event.start = start;
+    event.end = end;
+}
+
+void FlightRecorder::Counter(const char* name, double value) {
+    ProfileEvent& event = Push(PROFILE_COUNTER, name);
+    event.start = event.end = Now();
+    event.value = value;
+}
+
+void FlightRecorder::Input(uint8_t flags, uint32_t level, int16_t x, int16_t y) {
+    ProfileEvent& event = Push(PROFILE_INPUT, "Input");
+    event.start = event.end = Now();
+    event.args[0] = flags;
+    event.args[1] = (int32_t)level;
+    event.args[2] = x;
+    event.args[3] = y;
+}
+
+void FlightRecorder::StartDump() {
+    int64_t from = hitchStart - (int64_t)(PROFILE_WINDOW_BEFORE_SECONDS * NANOSECONDS_PER_SECOND);
+    size_t count = (size_t)std::min<uint64_t>(written, PROFILE_RING_CAPACITY);
+
+    std::vector<ProfileEvent> window;
+    for (uint64_t i = written - count; i < written; ++i) {
+        const ProfileEvent& event = ring[i % PROFILE_RING_CAPACITY];
+        if (event.end >= from) window.push_back(event);
+    }
+
+    double hitchMs = (hitchEnd - hitchStart) / 1e6;
+    std::string path = "hitches/hitch_" + std::to_string((long long)time(nullptr)) + "_frame" + std::to_string(frame) + ".json";
+
+    if (writer.joinable()) writer.join();
+    writer = std::thread([window = std::move(window), path, hitchMs]() {
+        std::error_code error;
+        std::filesystem::create_directories("hitches", error);
+        if (WriteChromeTrace(path, window, hitchMs)) {
+            printf("hitch: %.1f ms frame, trace written to %s\n", hitchMs, path.c_str());
+        }
+    });
+}
+
+FlightRecorder& Recorder() {
+    static FlightRecorder recorder;
+    return recorder;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+enum ProfileEventType : uint8_t {
+    PROFILE_FRAME,
+    PROFILE_ZONE,
+    PROFILE_COUNTER,
+    PROFILE_INPUT
+};
+
+// Names must be string literals; events keep the pointer.
+struct ProfileEvent {
+    int64_t start = 0;
+    int64_t end = 0;
+    const char* name = nullptr;
+    double value = 0;
+    int32_t args[4] = {};
+    ProfileEventType type = PROFILE_ZONE;
+};
+
+constexpr size_t PROFILE_RING_CAPACITY = 1 << 14;
+constexpr double PROFILE_WINDOW_BEFORE_SECONDS = 2.0;
+constexpr double PROFILE_WINDOW_AFTER_SECONDS = 0.5;
+constexpr double PROFILE_DUMP_COOLDOWN_SECONDS = 10.0;
+constexpr int PROFILE_WARMUP_FRAMES = 60;
+
+// Always-on flight recorder for the main thread. Zones, counters and input
+// go into a fixed ring; when a frame runs over budget the surrounding
+// window (the seconds before it and a little after) is written to
+// hitches/ as a Chrome trace, on a background thread so the dump does not
+// cause a hitch of its own.
+class FlightRecorder {
+private:
+    std::array<ProfileEvent, PROFILE_RING_CAPACITY> ring;
+    uint64_t written = 0;
+    int64_t origin;
+    int64_t frameStart = 0;
+    uint64_t frame = 0;
+    double budgetMs = 0;
+
+    int64_t hitchStart = -1;
+    int64_t hitchEnd = -1;
+    int64_t lastDump = -1;
+    std::thread writer;
+
+    ProfileEvent& Push(ProfileEventType type, const char* name);
+    void StartDump();
+
+public:
+    FlightRecorder();
+    ~FlightRecorder();
+
+    // Frames longer than budgetMs trigger a dump; 0 disables dumps but keeps
+    // recording.
+    void SetBudget(double ms) {
+        budgetMs = ms;
+    }
+
+    int64_t Now() const;
+
+    void BeginFrame();
+    // A frame that waited for input events is recorded as idle and never
+    // counts as a hitch.
+    void EndFrame(bool waited = false);
+    void Zone(const char* name, int64_t start, int64_t end);
+    void Counter(const char* name, double value);
+    void Input(uint8_t flags, uint32_t level, int16_t x, int16_t y);
+};
+
+FlightRecorder& Recorder();
+
+class ProfileZone {
+private:
+    const char* name;
+    int64_t start;
+
+public:
+    explicit ProfileZone(const char* zoneName) : name(zoneName), start(Recorder().Now()) {}
+
+    ~ProfileZone() {
+        Recorder().Zone(name, start, Recorder().Now());
+    }
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
@@ -0,0 +1,130 @@
+#include "random.h"
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RANDOM_SSE2 1
+#endif
+
+static const uint32_t PHILOX_M0 = 0xD2511F53u;
+static const uint32_t PHILOX_M1 = 0xCD9E8D57u;
+static const uint32_t PHILOX_W0 = 0x9E3779B9u;
+static const uint32_t PHILOX_W1 = 0xBB67AE85u;
+static const int PHILOX_ROUNDS = 10;
+static const float UNIT_FLOAT = 1.0f / (1u << 24);
+// Words generated at a time by FillFloats; a multiple of the 16-word batch.
+static const size_t FILL_FLOATS_BLOCK = 256;
+
+PhiloxCounter Philox4x32(PhiloxCounter counter, PhiloxKey key) {
+    for (int round = 0; round < PHILOX_ROUNDS; ++round) {
+        if (round > 0) {
+            key[0] += PHILOX_W0;
+            key[1] += PHILOX_W1;
+        }
+        uint64_t product0 = (uint64_t)PHILOX_M0 * counter[0];
+        uint64_t product1 = (uint64_t)PHILOX_M1 * counter[2];
+        counter = {
+            (uint32_t)(product1 >> 32) ^ counter[1] ^ key[0],
+            (uint32_t)product1,
+            (uint32_t)(product0 >> 32) ^ counter[3] ^ key[1],
+            (uint32_t)product0
+        };
+    }
+    return counter;
+}
+
+#ifdef RANDOM_SSE2
+// Low and high halves of the 32x32 bit products of four lanes with m.
+static void MulHiLo(__m128i x, __m128i m, __m128i& lo, __m128i& hi) {
+    const __m128i evenLanes = _mm_set_epi32(0, -1, 0, -1);
+    __m128i even = _mm_mul_epu32(x, m);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(x, 32), m);
+    lo = _mm_or_si128(_mm_and_si128(even, evenLanes), _mm_slli_epi64(odd, 32));
+    hi = _mm_or_si128(_mm_srli_epi64(even, 32), _mm_andnot_si128(evenLanes, odd));
+}
+
+// Four consecutive blocks at once. Each register holds one word of all
+// four counters; the result is transposed back to block order.
+static void Philox4x32Batch(const PhiloxCounter* counters, PhiloxKey key, uint32_t* out) {
+    __m128i x0 = _mm_setr_epi32((int)counters[0][0], (int)counters[1][0], (int)counters[2][0], (int)counters[3][0]);
+    __m128i x1 = _mm_setr_epi32((int)counters[0][1], (int)counters[1][1], (int)counters[2][1], (int)counters[3][1]);
+    __m128i x2 = _mm_setr_epi32((int)counters[0][2], (int)counters[1][2], (int)counters[2][2], (int)counters[3][2]);
+    __m128i x3 = _mm_setr_epi32((int)counters[0][3], (int)counters[1][3], (int)counters[2][3], (int)counters[3][3]);
+    const __m128i m0 = _mm_set1_epi32((int)PHILOX_M0);
+    const __m128i m1 = _mm_set1_epi32((int)PHILOX_M1);
+
+    for (int round = 0; round < PHILOX_ROUNDS; ++round) {
+        if (round > 0) {
+            key[0] += PHILOX_W0;
+            key[1] += PHILOX_W1;
+        }
+        __m128i lo0, hi0, lo1, hi1;
+        MulHiLo(x0, m0, lo0, hi0);
+        MulHiLo(x2, m1, lo1, hi1);
+        __m128i y0 = _mm_xor_si128(_mm_xor_si128(hi1, x1), _mm_set1_epi32((int)key[0]));
+        __m128i y2 = _mm_xor_si128(_mm_xor_si128(hi0, x3), _mm_set1_epi32((int)key[1]));
+        x0 = y0;
+        x1 = lo1;
+        x2 = y2;
+        x3 = lo0;
+    }
+
+    __m128i t0 = _mm_unpacklo_epi32(x0, x1);
+    __m128i t1 = _mm_unpacklo_epi32(x2, x3);
+    __m128i t2 = _mm_unpackhi_epi32(x0, x1);
+    __m128i t3 = _mm_unpackhi_epi32(x2, x3);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi64(t0, t1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4), _mm_unpackhi_epi64(t0, t1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), _mm_unpacklo_epi64(t2, t3));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 12), _mm_unpackhi_epi64(t2, t3));
+}
+#endif
+
+RandomStream::RandomStream(uint64_t seed, RandomDomain domain, uint32_t entity, uint32_t tick)
+    : key{ (uint32_t)seed, (uint32_t)(seed >> 32) ^ (domain * 0x85EBCA6Bu) }, entity(entity), tick(tick) {}
+
+PhiloxCounter RandomStream::Block(uint64_t index) const {
+    return { (uint32_t)index, (uint32_t)(index >> 32), entity, tick };
+}
+
+uint32_t RandomStream::NextU32() {
+    if (available == 0) {
+        buffered = Philox4x32(Block(nextBlock++), key);
+        available = 4;
+    }
+    return buffered[4 - available--];
+}
+
+float RandomStream::NextFloat() {
+    return (NextU32() >> 8) * UNIT_FLOAT;
+}
+
+float RandomStream::NextNormal() {
+    float u1 = ((NextU32() >> 8) + 1) * UNIT_FLOAT;
+    float u2 = NextFloat();
+    return std::sqrt(-2.0f * std::log(u1)) * std::cos(6.28318531f * u2);
+}
+
+void RandomStream::Fill(uint32_t* out, size_t count) {
+    size_t i = 0;
+    while (i < count && available > 0) out[i++] = NextU32();
+
+#ifdef RANDOM_SSE2
+    for (; i + 16 <= count; i += 16) {
+        PhiloxCounter counters[4] = { Block(nextBlock), Block(nextBlock + 1), Block(nextBlock + 2), Block(nextBlock + 3) };
+        Philox4x32Batch(counters, key, out + i);
+        nextBlock += 4;
+    }
+#endif
+    for (; i < count; ++i) out[i] = NextU32();
+}
+
+void RandomStream::FillFloats(float* out, size_t count) {
+    uint32_t bits[FILL_FLOATS_BLOCK];
+    for (size_t done = 0; done < count; done += FILL_FLOATS_BLOCK) {
+        size_t block = count - done < FILL_FLOATS_BLOCK ? count - done : FILL_FLOATS_BLOCK;
+        Fill(bits, block);
+        for (size_t i = 0; i < block; ++i) out[done + i] = (bits[i] >> 8) * UNIT_FLOAT;
+    }
+}
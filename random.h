@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+typedef std::array<uint32_t, 4> PhiloxCounter;
+typedef std::array<uint32_t, 2> PhiloxKey;
+
+// Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2,
+// 3"). A keyed bijection on 128-bit counters: the n-th random block is a
+// pure function of n, so nothing is shared between threads.
+PhiloxCounter Philox4x32(PhiloxCounter counter, PhiloxKey key);
+
+// Separates the subsystems that draw from the same seed.
+enum RandomDomain : uint32_t {
+    RANDOM_FRACTURE = 1,
+    RANDOM_DIFFICULTY = 2,
+    RANDOM_AUDIO = 3,
+    RANDOM_DAMAGE = 4
+};
+
+// One stream of random numbers, identified by seed, domain, entity and
+// tick. The seed and domain make the key; entity and tick fill the upper
+// half of the counter and the position within the stream the lower half,
+// so streams never overlap and what an entity draws on a tick does not
+// depend on who drew before it or on which thread.
+class RandomStream {
+private:
+    PhiloxKey key;
+    uint32_t entity;
+    uint32_t tick;
+    uint64_t nextBlock = 0;
+    PhiloxCounter buffered = {};
+    int available = 0;
+
+    PhiloxCounter Block(uint64_t index) const;
+
+public:
+    RandomStream(uint64_t seed, RandomDomain domain, uint32_t entity, uint32_t tick = 0);
+
+    uint32_t NextU32();
+
+    // Uniform in [0, 1), 24 bits.
+    float NextFloat();
+
+    // Standard normal, Box-Muller on two fresh uniforms per call.
+    float NextNormal();
+
+    // The next count values, exactly as count calls to NextU32 would return
+    // them. Whole blocks are generated four at a time with SSE2.
+    void Fill(uint32_t* out, size_t count);
+    void FillFloats(float* out, size_t count);
+};
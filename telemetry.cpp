@@ -0,0 +1,331 @@
+#include "telemetry.h"
+#include "platform.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <map>
+
+static const uint32_t SHOT_LOG_MAGIC = 0x4C534241;
+static const uint32_t SHOT_LOG_BLOCK_MAGIC = 0x4B4C4253;
+static const uint16_t SHOT_LOG_VERSION = 1;
+static const size_t SHOT_LOG_HEADER_BYTES = 8;
+
+static const bool SHOT_COLUMN_IS_FLOAT[SHOT_COLUMN_COUNT] = {
+    false, true, true, false, false, false, false, false, true, true
+};
+
+static uint32_t FloatBits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static float BitsFloat(uint32_t bits) {
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+ShotLogWriter::~ShotLogWriter() {
+    Close();
+}
+
+bool ShotLogWriter::Open(const std::string& logPath) {
+    Close();
+    path = logPath;
+
+    MappedFile mapped;
+    if (mapped.Open(path.c_str())) {
+        std::vector<ShotLogBlock> blocks;
+        size_t end = 0;
+        size_t size = mapped.Size();
+        bool readable = ReadShotLogBlocks(mapped.Data(), size, blocks, end);
+        mapped.Close();
+        if (!readable) return false;
+
+        if (end < size) {
+            std::error_code error;
+            std::filesystem::resize_file(path, end, error);
+            if (error) return false;
+        }
+    }
+
+    file = fopen(path.c_str(), "ab+");
+    if (file == nullptr) return false;
+
+    fseek(file, 0, SEEK_END);
+    long existing = ftell(file);
+    if (existing == 0) {
+        uint32_t header[2] = { SHOT_LOG_MAGIC, SHOT_LOG_VERSION | ((uint32_t)SHOT_COLUMN_COUNT << 16) };
+        fwrite(header, sizeof(header), 1, file);
+        return true;
+    }
+
+    uint32_t header[2] = {};
+    fseek(file, 0, SEEK_SET);
+    bool compatible = fread(header, sizeof(header), 1, file) == 1 && header[0] == SHOT_LOG_MAGIC &&
+        header[1] == (SHOT_LOG_VERSION | ((uint32_t)SHOT_COLUMN_COUNT << 16));
+    fseek(file, 0, SEEK_END);
+
+    if (!compatible) {
+        fclose(file);
+        file = nullptr;
+    }
+    return compatible;
+}
+
+void ShotLogWriter::Append(const ShotRecord& shot) {
+    if (file == nullptr) return;
+
+    columns[SHOT_LEVEL].push_back((uint32_t)shot.level);
+    columns[SHOT_DRAG_X].push_back(FloatBits(shot.dragX));
+    columns[SHOT_DRAG_Y].push_back(FloatBits(shot.dragY));
+    columns[SHOT_SPLIT_TICK].push_back((uint32_t)shot.splitTick);
+    columns[SHOT_BLOCKS_DESTROYED].push_back((uint32_t)shot.blocksDestroyed);
+    columns[SHOT_FINAL_SCORE].push_back((uint32_t)shot.finalScore);
+    columns[SHOT_COMPLETED].push_back((uint32_t)shot.completed);
+    columns[SHOT_FLIGHT_TICKS].push_back((uint32_t)shot.flightTicks);
+    columns[SHOT_FRAME_MS_AVG].push_back(FloatBits(shot.frameMsAvg));
+    columns[SHOT_FRAME_MS_MAX].push_back(FloatBits(shot.frameMsMax));
+
+    if (columns[0].size() >= SHOT_LOG_BLOCK_ROWS) {
+        Flush();
+    }
+}
+
+bool ShotLogWriter::Flush() {
+    uint32_t rows = (uint32_t)columns[0].size();
+    if (file == nullptr || rows == 0) return file != nullptr;
+
+    uint32_t min[SHOT_COLUMN_COUNT];
+    uint32_t max[SHOT_COLUMN_COUNT];
+    for (int c = 0; c < SHOT_COLUMN_COUNT; ++c) {
+        const std::vector<uint32_t>& values = columns[c];
+        if (SHOT_COLUMN_IS_FLOAT[c]) {
+            float lo = BitsFloat(values[0]), hi = lo;
+            for (uint32_t bits : values) {
+                lo = std::min(lo, BitsFloat(bits));
+                hi = std::max(hi, BitsFloat(bits));
+            }
+            min[c] = FloatBits(lo);
+            max[c] = FloatBits(hi);
+        }
+        else {
+            int32_t lo = (int32_t)values[0], hi = lo;
+            for (uint32_t bits : values) {
+                lo = std::min(lo, (int32_t)bits);
+                hi = std::max(hi, (int32_t)bits);
+            }
+            min[c] = (uint32_t)lo;
+            max[c] = (uint32_t)hi;
+        }
+    }
+
+    fseek(file, 0, SEEK_END);
+    long blockStart = ftell(file);
+
+    uint32_t blockHeader[2] = { SHOT_LOG_BLOCK_MAGIC, rows };
+    bool ok = fwrite(blockHeader, sizeof(blockHeader), 1, file) == 1 &&
+        fwrite(min, sizeof(min), 1, file) == 1 &&
+        fwrite(max, sizeof(max), 1, file) == 1;
+    for (int c = 0; c < SHOT_COLUMN_COUNT && ok; ++c) {
+        ok = fwrite(columns[c].data(), sizeof(uint32_t), rows, file) == rows;
+        columns[c].clear();
+    }
+    ok = fflush(file) == 0 && ok;
+
+    // Cut off whatever part of the block did get written, so blocks appended
+    // later still follow a whole one.
+    if (!ok && blockStart >= 0) {
+        fclose(file);
+        std::error_code error;
+        std::filesystem::resize_file(path, (uintmax_t)blockStart, error);
+        file = fopen(path.c_str(), "ab+");
+    }
+    return ok;
+}
+
+void ShotLogWriter::Close() {
+    if (file == nullptr) return;
+
+    Flush();
+    fclose(file);
+    file = nullptr;
+}
+
+bool ReadShotLogBlocks(const unsigned char* data, size_t size, std::vector<ShotLogBlock>& blocks, size_t& end) {
+    blocks.clear();
+    end = 0;
+    if (size < SHOT_LOG_HEADER_BYTES) return false;
+
+    const uint32_t* header = reinterpret_cast<const uint32_t*>(data);
+    if (header[0] != SHOT_LOG_MAGIC || header[1] != (SHOT_LOG_VERSION | ((uint32_t)SHOT_COLUMN_COUNT << 16))) {
+        return false;
+    }
+
+    size_t offset = SHOT_LOG_HEADER_BYTES;
+    const size_t blockHeaderBytes = sizeof(uint32_t) * (2 + 2 * SHOT_COLUMN_COUNT);
+    while (offset + blockHeaderBytes <= size) {
+        const uint32_t* words = reinterpret_cast<const uint32_t*>(data + offset);
+        if (words[0] != SHOT_LOG_BLOCK_MAGIC) return false;
+
+        ShotLogBlock block;
+        block.rows = words[1];
+        block.min = words + 2;
+        block.max = words + 2 + SHOT_COLUMN_COUNT;
+
+        size_t columnBytes = (size_t)block.rows * sizeof(uint32_t);
+        if (block.rows > SHOT_LOG_BLOCK_ROWS) return false;
+        if (offset + blockHeaderBytes + columnBytes * SHOT_COLUMN_COUNT > size) break;
+
+        const unsigned char* columnData = data + offset + blockHeaderBytes;
+        for (int c = 0; c < SHOT_COLUMN_COUNT; ++c) {
+            block.columns[c] = reinterpret_cast<const uint32_t*>(columnData + c * columnBytes);
+        }
+
+        blocks.push_back(block);
+        offset += blockHeaderBytes + columnBytes * SHOT_COLUMN_COUNT;
+    }
+
+    end = offset;
+    return true;
+}
+
+// Plain loops over contiguous columns; the compiler vectorizes these.
+static int64_t SumInts(const int32_t* values, uint32_t count) {
+    int64_t sum = 0;
+    for (uint32_t i = 0; i < count; ++i) sum += values[i];
+    return sum;
+}
+
+static int64_t CountNonNegative(const int32_t* values, uint32_t count) {
+    int64_t total = 0;
+    for (uint32_t i = 0; i < count; ++i) total += values[i] >= 0;
+    return total;
+}
+
+static double SumFloats(const float* values, uint32_t count) {
+    float sum = 0;
+    for (uint32_t i = 0; i < count; ++i) sum += values[i];
+    return sum;
+}
+
+static const int SCORE_BIN_POINTS = 10;
+static const int SCORE_BINS = 1024;
+
+struct LevelAggregate {
+    int64_t shots = 0;
+    int64_t completed = 0;
+    int64_t blocksDestroyed = 0;
+    int64_t splits = 0;
+    int64_t scoreSum = 0;
+    double frameMsSum = 0;
+    float frameMsMax = 0;
+    std::vector<int64_t> scoreHistogram = std::vector<int64_t>(SCORE_BINS, 0);
+
+    void AddScore(int32_t score) {
+        int bin = std::max(0, std::min(SCORE_BINS - 1, score / SCORE_BIN_POINTS));
+        scoreHistogram[bin]++;
+    }
+
+    int Percentile(double fraction) const {
+        int64_t target = (int64_t)(fraction * (shots - 1));
+        int64_t seen = 0;
+        for (int bin = 0; bin < SCORE_BINS; ++bin) {
+            seen += scoreHistogram[bin];
+            if (seen > target) return bin * SCORE_BIN_POINTS;
+        }
+        return (SCORE_BINS - 1) * SCORE_BIN_POINTS;
+    }
+};
+
+static void AggregateUniformBlock(const ShotLogBlock& block, LevelAggregate& level) {
+    uint32_t rows = block.rows;
+    const int32_t* scores = block.Ints(SHOT_FINAL_SCORE);
+
+    level.shots += rows;
+    level.completed += SumInts(block.Ints(SHOT_COMPLETED), rows);
+    level.blocksDestroyed += SumInts(block.Ints(SHOT_BLOCKS_DESTROYED), rows);
+    level.splits += CountNonNegative(block.Ints(SHOT_SPLIT_TICK), rows);
+    level.scoreSum += SumInts(scores, rows);
+    level.frameMsSum += SumFloats(block.Floats(SHOT_FRAME_MS_AVG), rows);
+    level.frameMsMax = std::max(level.frameMsMax, BitsFloat(block.max[SHOT_FRAME_MS_MAX]));
+
+    if (block.MinInt(SHOT_FINAL_SCORE) == block.MaxInt(SHOT_FINAL_SCORE)) {
+        int bin = std::max(0, std::min(SCORE_BINS - 1, block.MinInt(SHOT_FINAL_SCORE) / SCORE_BIN_POINTS));
+        level.scoreHistogram[bin] += rows;
+    }
+    else {
+        for (uint32_t i = 0; i < rows; ++i) level.AddScore(scores[i]);
+    }
+}
+
+static void AggregateMixedBlock(const ShotLogBlock& block, std::map<int32_t, LevelAggregate>& levels) {
+    const int32_t* levelIds = block.Ints(SHOT_LEVEL);
+    const int32_t* completed = block.Ints(SHOT_COMPLETED);
+    const int32_t* blocksDestroyed = block.Ints(SHOT_BLOCKS_DESTROYED);
+    const int32_t* splitTicks = block.Ints(SHOT_SPLIT_TICK);
+    const int32_t* scores = block.Ints(SHOT_FINAL_SCORE);
+    const float* frameMsAvg = block.Floats(SHOT_FRAME_MS_AVG);
+    const float* frameMsMax = block.Floats(SHOT_FRAME_MS_MAX);
+
+    for (uint32_t i = 0; i < block.rows; ++i) {
+        LevelAggregate& level = levels[levelIds[i]];
+        level.shots++;
+        level.completed += completed[i];
+        level.blocksDestroyed += blocksDestroyed[i];
+        level.splits += splitTicks[i] >= 0;
+        level.scoreSum += scores[i];
+        level.frameMsSum += frameMsAvg[i];
+        level.frameMsMax = std::max(level.frameMsMax, frameMsMax[i]);
+        level.AddScore(scores[i]);
+    }
+}
+
+int RunShotReport(const std::vector<std::string>& paths) {
+    auto start = std::chrono::steady_clock::now();
+    std::map<int32_t, LevelAggregate> levels;
+    size_t blockCount = 0;
+
+    for (const std::string& path : paths) {
+        MappedFile file;
+        std::vector<ShotLogBlock> blocks;
+        size_t end = 0;
+        if (!file.Open(path.c_str()) || !ReadShotLogBlocks(file.Data(), file.Size(), blocks, end)) {
+            fprintf(stderr, "%s: not a readable shot log\n", path.c_str());
+            return 1;
+        }
+        if (end < file.Size()) {
+            fprintf(stderr, "%s: skipping %zu bytes of an incomplete final block\n", path.c_str(), file.Size() - end);
+        }
+
+        for (const ShotLogBlock& block : blocks) {
+            if (block.MinInt(SHOT_LEVEL) == block.MaxInt(SHOT_LEVEL)) {
+                AggregateUniformBlock(block, levels[block.MinInt(SHOT_LEVEL)]);
+            }
+            else {
+                AggregateMixedBlock(block, levels);
+            }
+        }
+        blockCount += blocks.size();
+    }
+
+    double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    int64_t totalShots = 0;
+    printf("%-6s %10s %8s %9s %6s %6s %6s %6s %10s %7s %9s %9s\n", "level", "shots", "success", "avg score",
+        "p10", "p50", "p90", "max", "avg blocks", "split%", "avg ms", "max ms");
+    for (const auto& entry : levels) {
+        const LevelAggregate& level = entry.second;
+        double shots = (double)level.shots;
+        printf("%-6d %10lld %7.1f%% %9.1f %6d %6d %6d %6d %10.2f %6.1f%% %9.2f %9.2f\n", entry.first,
+            (long long)level.shots, 100.0 * level.completed / shots, level.scoreSum / shots,
+            level.Percentile(0.1), level.Percentile(0.5), level.Percentile(0.9), level.Percentile(1.0),
+            level.blocksDestroyed / shots, 100.0 * level.splits / shots, level.frameMsSum / shots, level.frameMsMax);
+        totalShots += level.shots;
+    }
+    printf("%lld shots in %zu blocks scanned in %.1f ms\n", (long long)totalShots, blockCount, milliseconds);
+    return 0;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// One launch, from release until every ball stopped or the level completed.
+struct ShotRecord {
+    int32_t level = 0;
+    float dragX = 0;
+    float dragY = 0;
+    int32_t splitTick = -1;
+    int32_t blocksDestroyed = 0;
+    int32_t finalScore = 0;
+    int32_t completed = 0;
+    int32_t flightTicks = 0;
+    float frameMsAvg = 0;
+    float frameMsMax = 0;
+};
+
+enum ShotColumn {
+    SHOT_LEVEL,
+    SHOT_DRAG_X,
+    SHOT_DRAG_Y,
+    SHOT_SPLIT_TICK,
+    SHOT_BLOCKS_DESTROYED,
+    SHOT_FINAL_SCORE,
+    SHOT_COMPLETED,
+    SHOT_FLIGHT_TICKS,
+    SHOT_FRAME_MS_AVG,
+    SHOT_FRAME_MS_MAX,
+    SHOT_COLUMN_COUNT
+};
+
+constexpr uint32_t SHOT_LOG_BLOCK_ROWS = 4096;
+
+// Shot logs are a file header followed by self-describing blocks. A block
+// holds up to SHOT_LOG_BLOCK_ROWS rows stored column by column, every column
+// 4 bytes wide, with the min and max of each column in the block header so
+// scans can skip or shortcut whole blocks. Values are in the writing host's
+// byte order, so readers can use the columns in place; a log written on a
+// host of the other order fails the header check. A block cut short by a
+// crash or failed write is trimmed before the next append.
+class ShotLogWriter {
+private:
+    FILE* file = nullptr;
+    std::string path;
+    std::array<std::vector<uint32_t>, SHOT_COLUMN_COUNT> columns;
+
+public:
+    ~ShotLogWriter();
+
+    bool Open(const std::string& path);
+    void Append(const ShotRecord& shot);
+    bool Flush();
+    void Close();
+
+    bool IsOpen() const {
+        return file != nullptr;
+    }
+};
+
+struct ShotLogBlock {
+    uint32_t rows = 0;
+    const uint32_t* min = nullptr;
+    const uint32_t* max = nullptr;
+    const uint32_t* columns[SHOT_COLUMN_COUNT] = {};
+
+    const int32_t* Ints(ShotColumn column) const {
+        return reinterpret_cast<const int32_t*>(columns[column]);
+    }
+
+    const float* Floats(ShotColumn column) const {
+        return reinterpret_cast<const float*>(columns[column]);
+    }
+
+    int32_t MinInt(ShotColumn column) const {
+        return (int32_t)min[column];
+    }
+
+    int32_t MaxInt(ShotColumn column) const {
+        return (int32_t)max[column];
+    }
+};
+
+// Parses the block directory of a memory-mapped shot log. Blocks point
+// straight into the mapping; nothing is copied. Stops at an incomplete final
+// block and sets end to the bytes the whole blocks cover.
+bool ReadShotLogBlocks(const unsigned char* data, size_t size, std::vector<ShotLogBlock>& blocks, size_t& end);
+
+// Prints per-level success rates and score distributions for the given logs.
+int RunShotReport(const std::vector<std::string>& paths);